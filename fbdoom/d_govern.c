@@ -0,0 +1,234 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Load governor.  Times the tics and the refresh of every
+//	frame with the cycle counter, and when they no longer fit
+//	in the frame budget, steps down to low detail, then to a
+//	smaller view, then to skipping frames, until they do.
+//	Steps back up once there is room to spare again.
+//
+
+#include "stdio.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "d_govern.h"
+#include "d_loop.h"
+#include "i_timer.h"
+#include "m_menu.h"
+#include "r_main.h"
+
+// The governor never shrinks the view below this.
+
+#define GOVERN_MINBLOCKS	6
+
+// Most frames in a row that are left undrawn.
+
+#define GOVERN_MAXSKIP		2
+
+// Frames to let a new level settle before judging it.
+
+#define GOVERN_HOLD		TICRATE
+
+// Weight of each new sample in the running costs, as a shift.
+
+#define GOVERN_SMOOTH		3
+
+// Cycle counter rate.  It comes from the build, as the
+// millisecond timer counts calls on this board and cannot be
+// timed against.
+
+#define GOVERN_CYCLESPERSEC	((int64_t) CLOCK_MHZ * 1000000)
+
+int govern_target_fps = 0;
+int govern_hysteresis = 25;
+
+static boolean		started;
+
+static uint64_t		lastticcycles;
+static int		lastgametic;
+
+// Running costs of one tic and of one drawn refresh.
+
+static int64_t		ticcost;
+static int64_t		rendercost;
+
+static int		level;
+static int		holdframes;
+static int		skipped;
+
+//
+// D_LevelSettings
+// What the view looks like at a governor level: low detail
+// first, then one block smaller at a time, then frames left
+// undrawn.  Returns false past the last level.
+//
+static boolean D_LevelSettings (int lev, int *blocks, int *detail, int *skip)
+{
+    *blocks = screenblocks;
+    *detail = detailLevel;
+
+    if (lev > 0 && !*detail)
+    {
+	*detail = 1;
+	lev--;
+    }
+
+    while (lev > 0 && *blocks > GOVERN_MINBLOCKS)
+    {
+	(*blocks)--;
+	lev--;
+    }
+
+    *skip = lev;
+
+    return lev <= GOVERN_MAXSKIP;
+}
+
+//
+// D_Load
+// Share of each second the tics and refreshes would take at
+// a level, in percent.
+//
+static int D_Load (int lev)
+{
+    int		blocks;
+    int		detail;
+    int		skip;
+    int64_t	cycles;
+
+    D_LevelSettings (lev, &blocks, &detail, &skip);
+
+    cycles = ticcost * TICRATE
+	   + rendercost * govern_target_fps / (skip + 1);
+
+    return (int) (cycles * 100 / GOVERN_CYCLESPERSEC);
+}
+
+//
+// D_SetLevel
+//
+static void D_SetLevel (int lev, int load)
+{
+    int		blocks;
+    int		detail;
+    int		skip;
+
+    level = lev;
+    holdframes = GOVERN_HOLD;
+    skipped = 0;
+
+    D_LevelSettings (level, &blocks, &detail, &skip);
+
+    printf ("D_Govern: load %i%%, level %i: %s detail, %i blocks, "
+	    "skip %i\n", load, level, detail ? "low" : "high", blocks, skip);
+}
+
+//
+// D_GovernSkipFrame
+//
+boolean D_GovernSkipFrame (void)
+{
+    int		blocks;
+    int		detail;
+    int		skip;
+
+    if (!level || gamestate != GS_LEVEL || menuactive)
+    {
+	skipped = 0;
+	return false;
+    }
+
+    D_LevelSettings (level, &blocks, &detail, &skip);
+
+    if (skipped < skip)
+    {
+	skipped++;
+	return true;
+    }
+
+    skipped = 0;
+    return false;
+}
+
+//
+// D_GovernFrame
+//
+void D_GovernFrame (boolean drawn, uint64_t rendercycles)
+{
+    int		blocks;
+    int		detail;
+    int		skip;
+    int		tics;
+    int		load;
+
+    if (!govern_target_fps || singletics || nodrawers)
+	return;
+
+    if (!started)
+    {
+	printf ("D_Govern: %i MHz cycle counter, holding %i fps\n",
+		CLOCK_MHZ, govern_target_fps);
+
+	// the first tics are counted from here
+	lastticcycles = ticcycles;
+	lastgametic = gametic;
+	started = true;
+	return;
+    }
+
+    tics = gametic - lastgametic;
+
+    if (tics > 0)
+    {
+	ticcost += ((int64_t) (ticcycles - lastticcycles) / tics - ticcost)
+		 >> GOVERN_SMOOTH;
+    }
+
+    lastgametic = gametic;
+    lastticcycles = ticcycles;
+
+    // only the view refresh is worth governing
+    if (gamestate != GS_LEVEL)
+	return;
+
+    if (drawn)
+	rendercost += ((int64_t) rendercycles - rendercost) >> GOVERN_SMOOTH;
+
+    if (holdframes > 0)
+    {
+	holdframes--;
+    }
+    else
+    {
+	load = D_Load (level);
+
+	if (load > 100)
+	{
+	    if (D_LevelSettings (level + 1, &blocks, &detail, &skip))
+		D_SetLevel (level + 1, load);
+	}
+	else if (level > 0 && load < 100 - govern_hysteresis)
+	{
+	    D_SetLevel (level - 1, load);
+	}
+    }
+
+    // the menu sets the view back to the player's choice
+    D_LevelSettings (level, &blocks, &detail, &skip);
+
+    if (blocks != setblocks || detail != setdetail)
+	R_SetViewSize (blocks, detail);
+}
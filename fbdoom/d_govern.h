@@ -0,0 +1,37 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Load governor.
+//
+
+
+#ifndef __D_GOVERN__
+#define __D_GOVERN__
+
+#include "doomtype.h"
+
+// Frames per second to hold, or 0 to leave the view alone.
+extern int govern_target_fps;
+
+// Percent under budget needed before detail is given back.
+extern int govern_hysteresis;
+
+// True if the main loop should not draw this frame.
+boolean D_GovernSkipFrame (void);
+
+// Called once per main loop pass, with whether the frame was
+// drawn and the cycles D_Display took.
+void D_GovernFrame (boolean drawn, uint64_t rendercycles);
+
+#endif
@@ -39,6 +39,7 @@
 #include "net_server.h"
 #include "net_sdl.h"
 #include "net_loop.h"
+#include "net_serial.h"
 
 // The complete set of data for a particular tic.
 
@@ -76,6 +77,53 @@ int gametic;
 
 boolean singletics = false;
 
+// When non-zero, TryRunTics() returns as soon as there is no tic to
+// run so that another frame can be drawn, and the renderer places
+// things between their last two tics.
+
+int uncapped_framerate = 0;
+
+// Cycles spent running tics, for the load governor.
+
+uint64_t ticcycles;
+
+// In a netgame, the most tics the game may run ahead of the
+// ticcmds received, on guesses at the ones to come.  Tics
+// guessed wrongly are run again once the real ones arrive.
+// Zero waits for them as Vanilla does.
+
+int predict_tics = 0;
+
+// The ticcmds each tic was run with, guesses and all, to check
+// against the real ones when they arrive.
+
+static ticcmd_set_t rundata[BACKUPTICS];
+
+// Tics before this have run on real ticcmds only, and will not
+// be run again.
+
+static int confirmtic;
+
+// Game state checksums after each tic, and a running hash of
+// those of the confirmed tics, which is the same at every end
+// of a game in sync.
+
+static unsigned int ticsums[BACKUPTICS];
+static unsigned int confirmsum;
+
+// Set when the game could not be kept to come back to, so no tic
+// may run on guesses until the real ticcmds allow one.
+
+static boolean predictstalled;
+
+static int rollbacks;
+static int reruntics;
+
+// Where D_SimulateNetGame wants the checksums.
+
+static unsigned int *simsums;
+static int simnumtics;
+
 // Index of the local player.
 
 static int localplayer;
@@ -133,6 +181,42 @@ static int GetAdjustedTime(void)
     return (time_ms * TICRATE) / 1000;
 }
 
+// True if tics may run ahead of the ticcmds received.
+
+static boolean PredictionOn(void)
+{
+    return predict_tics > 0
+        && net_client_connected
+        && !drone
+        && ticdup == 1
+        && loop_interface->SaveTic != NULL;
+}
+
+// Send a new tic made at this end, and keep it to run.
+
+static void StoreNewTic(ticcmd_t *cmd)
+{
+#ifdef FEATURE_MULTIPLAYER
+
+    if (net_client_connected)
+    {
+        NET_CL_SendTiccmd(cmd, maketic);
+    }
+
+#else
+
+    if (net_client_connected)
+    {
+        NET_SerialSendTiccmd(cmd, maketic);
+    }
+
+#endif
+    ticdata[maketic % BACKUPTICS].cmds[localplayer] = *cmd;
+    ticdata[maketic % BACKUPTICS].ingame[localplayer] = true;
+
+    ++maketic;
+}
+
 static boolean BuildNewTic(void)
 {
     int	gameticdiv;
@@ -177,22 +261,12 @@ static boolean BuildNewTic(void)
     memset(&cmd, 0, sizeof(ticcmd_t));
     loop_interface->BuildTiccmd(&cmd, maketic);
 
-#ifdef FEATURE_MULTIPLAYER
-
-    if (net_client_connected)
-    {
-        NET_CL_SendTiccmd(&cmd, maketic);
-    }
-
-#endif
-    ticdata[maketic % BACKUPTICS].cmds[localplayer] = cmd;
-    ticdata[maketic % BACKUPTICS].ingame[localplayer] = true;
-
-    ++maketic;
+    StoreNewTic(&cmd);
 
     return true;
 }
 
+
 //
 // NetUpdate
 // Builds ticcmds for console player,
@@ -219,6 +293,10 @@ void NetUpdate (void)
     NET_CL_Run();
     NET_SV_Run();
 
+#else
+
+    NET_SerialRun();
+
 #endif
 
     // check time
@@ -340,9 +418,9 @@ static void BlockUntilStart(net_gamesettings_t *settings,
 void D_StartNetGame(net_gamesettings_t *settings,
                     netgame_startup_callback_t callback)
 {
-#if ORIGCODE
     int i;
 
+#if ORIGCODE
     offsetms = 0;
     recvtic = 0;
 
@@ -444,9 +522,26 @@ void D_StartNetGame(net_gamesettings_t *settings,
 	settings->extratics = 1;
 	settings->ticdup = 1;
 
+    if (net_client_connected)
+    {
+        // Two players across the serial link, synced like Vanilla.
+
+        settings->consoleplayer = NET_SerialConsolePlayer();
+        settings->num_players = 2;
+    }
+
+    localplayer = settings->consoleplayer;
+
+    for (i = 0; i < NET_MAXPLAYERS; ++i)
+    {
+        local_playeringame[i] = i < settings->num_players;
+    }
+
 	ticdup = settings->ticdup;
 	new_sync = settings->new_sync;
 #endif
+
+    confirmtic = gametic / ticdup;
 }
 
 boolean D_InitNetGame(net_connect_data_t *connect_data)
@@ -546,6 +641,15 @@ boolean D_InitNetGame(net_connect_data_t *connect_data)
 
         result = true;
     }
+#else
+
+    //!
+    // @category net
+    //
+    // Play a two player game across the serial link.
+    //
+
+    result = NET_SerialConnect();
 #endif
 
     return result;
@@ -559,27 +663,65 @@ boolean D_InitNetGame(net_connect_data_t *connect_data)
 //
 void D_QuitNetGame (void)
 {
+    if (PredictionOn())
+    {
+        printf("D_QuitNetGame: %i tics confirmed, checksum %08x; "
+               "%i wrong guesses ran %i tics again\n",
+               confirmtic, confirmsum, rollbacks, reruntics);
+    }
+
 #ifdef FEATURE_MULTIPLAYER
     NET_SV_Shutdown();
     NET_CL_Disconnect();
+#else
+    NET_SerialDisconnect();
 #endif
 }
 
 static int GetLowTic(void)
 {
     int lowtic;
+    int predicttic;
 
     lowtic = maketic;
 
-#ifdef FEATURE_MULTIPLAYER
     if (net_client_connected)
     {
         if (drone || recvtic < lowtic)
         {
             lowtic = recvtic;
         }
+
+        // Run ahead on guesses as far as there are tics kept to
+        // come back to.  Tics already run stay run while no more
+        // can be kept.
+
+        if (PredictionOn())
+        {
+            if (predictstalled)
+            {
+                predicttic = gametic;
+            }
+            else if (predict_tics < MAXPREDICTTICS)
+            {
+                predicttic = recvtic + predict_tics;
+            }
+            else
+            {
+                predicttic = recvtic + MAXPREDICTTICS;
+            }
+
+            if (predicttic > maketic)
+            {
+                predicttic = maketic;
+            }
+
+            if (predicttic > lowtic)
+            {
+                lowtic = predicttic;
+            }
+        }
     }
-#endif
 
     return lowtic;
 }
@@ -699,13 +841,223 @@ static void SinglePlayerClear(ticcmd_set_t *set)
     }
 }
 
+static boolean SameTiccmd(ticcmd_t *a, ticcmd_t *b)
+{
+    return a->forwardmove == b->forwardmove
+        && a->sidemove == b->sidemove
+        && a->angleturn == b->angleturn
+        && a->chatchar == b->chatchar
+        && a->buttons == b->buttons
+        && a->consistancy == b->consistancy;
+}
+
+static boolean SameTicSet(ticcmd_set_t *a, ticcmd_set_t *b)
+{
+    unsigned int i;
+
+    for (i = 0; i < NET_MAXPLAYERS; ++i)
+    {
+        if (a->ingame[i] != b->ingame[i])
+        {
+            return false;
+        }
+
+        if (a->ingame[i] && !SameTiccmd(&a->cmds[i], &b->cmds[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Guess the ticcmds of the other players for a tic not yet
+// received: each goes on as in the last tic that was.
+
+static ticcmd_set_t *PredictTicSet(int tic)
+{
+    ticcmd_set_t *set;
+    ticcmd_set_t *last;
+    unsigned int i;
+
+    set = &rundata[tic % BACKUPTICS];
+    *set = ticdata[tic % BACKUPTICS];
+
+    last = recvtic > 0 ? &ticdata[(recvtic - 1) % BACKUPTICS] : NULL;
+
+    for (i = 0; i < NET_MAXPLAYERS; ++i)
+    {
+        if (i == localplayer)
+        {
+            continue;
+        }
+
+        if (last != NULL)
+        {
+            set->cmds[i] = last->cmds[i];
+            set->ingame[i] = last->ingame[i];
+        }
+        else
+        {
+            memset(&set->cmds[i], 0, sizeof(ticcmd_t));
+            set->ingame[i] = local_playeringame[i];
+        }
+
+        if (set->ingame[i])
+        {
+            loop_interface->PredictTiccmd(&set->cmds[i], i, tic);
+        }
+    }
+
+    return set;
+}
+
+// The game state after a tic is final once the tic and all those
+// before it have run on real ticcmds.
+
+static void ConfirmTic(int tic)
+{
+    confirmsum = (confirmsum ^ ticsums[tic % BACKUPTICS]) * 16777619u;
+
+    if (simsums != NULL && tic < simnumtics)
+    {
+        simsums[tic] = ticsums[tic % BACKUPTICS];
+    }
+}
+
+// Run the next tic, on guesses for the ticcmds not yet received.
+// Returns false if it cannot be, until more are received.
+
+static boolean RunGameTic(int lowtic)
+{
+    ticcmd_set_t *set;
+    uint64_t start;
+    int tic;
+    int i;
+
+    tic = gametic / ticdup;
+    set = &ticdata[tic % BACKUPTICS];
+
+    if (!net_client_connected)
+    {
+        SinglePlayerClear(set);
+    }
+
+    if (PredictionOn())
+    {
+        if (tic >= recvtic)
+        {
+            if (!loop_interface->SaveTic(tic))
+            {
+                predictstalled = true;
+                return false;
+            }
+
+            set = PredictTicSet(tic);
+        }
+        else
+        {
+            rundata[tic % BACKUPTICS] = *set;
+            predictstalled = false;
+        }
+    }
+
+    for (i=0 ; i<ticdup ; i++)
+    {
+        if (gametic/ticdup > lowtic)
+            I_Error ("gametic>lowtic");
+
+        memcpy(local_playeringame, set->ingame, sizeof(local_playeringame));
+
+        start = I_GetCycles();
+        loop_interface->RunTic(set->cmds, set->ingame);
+        ticcycles += I_GetCycles() - start;
+        gametic++;
+
+        // modify command for duplicated tics
+
+        TicdupSquash(set);
+    }
+
+    if (PredictionOn() || simsums != NULL)
+    {
+        ticsums[tic % BACKUPTICS] = loop_interface->StateChecksum();
+    }
+
+    // Without guesses, every tic is final as soon as it has run.
+
+    if (!PredictionOn())
+    {
+        if (simsums != NULL)
+        {
+            ConfirmTic(tic);
+        }
+
+        confirmtic = tic + 1;
+    }
+
+    return true;
+}
+
+// Check the guesses tics were run with against the real ticcmds
+// as they arrive.  At the first tic guessed wrongly, put the game
+// back to how it was before it, and run it and the tics after it
+// again.
+
+static void CheckPredictions(void)
+{
+    int tic;
+    int lasttic;
+
+    if (!PredictionOn())
+    {
+        return;
+    }
+
+    for (tic = confirmtic; tic < recvtic && tic < gametic; ++tic)
+    {
+        if (!SameTicSet(&ticdata[tic % BACKUPTICS],
+                        &rundata[tic % BACKUPTICS]))
+        {
+            break;
+        }
+
+        ConfirmTic(tic);
+    }
+
+    confirmtic = tic;
+
+    if (tic >= recvtic || tic >= gametic)
+    {
+        return;
+    }
+
+    lasttic = gametic;
+
+    loop_interface->RestoreTic(tic);
+    gametic = tic;
+
+    ++rollbacks;
+    reruntics += lasttic - tic;
+
+    while (gametic < lasttic && RunGameTic(lasttic))
+    {
+        if (gametic - 1 < recvtic)
+        {
+            // run on real ticcmds, from a confirmed state
+
+            ConfirmTic(gametic - 1);
+            confirmtic = gametic;
+        }
+    }
+}
+
 //
 // TryRunTics
 //
 
 void TryRunTics (void)
 {
-    int	i;
     int	lowtic;
     int	entertic;
     static int oldentertics;
@@ -781,6 +1133,13 @@ void TryRunTics (void)
 	{
 	    return;
 	}
+
+        // Draw another in-between frame instead of waiting.
+
+        if (uncapped_framerate)
+        {
+            return;
+        }
 	//printf("try to sleep\n");
         I_Sleep(1);
     }
@@ -788,34 +1147,18 @@ void TryRunTics (void)
     // run the count * ticdup dics
     while (counts--)
     {
-        ticcmd_set_t *set;
-
         if (!PlayersInGame())
         {
             return;
         }
 
-        set = &ticdata[(gametic / ticdup) % BACKUPTICS];
+        CheckPredictions();
 
-        if (!net_client_connected)
+        if (!RunGameTic(lowtic))
         {
-            SinglePlayerClear(set);
+            return;
         }
 
-	for (i=0 ; i<ticdup ; i++)
-	{
-            if (gametic/ticdup > lowtic)
-                I_Error ("gametic>lowtic");
-
-            memcpy(local_playeringame, set->ingame, sizeof(local_playeringame));
-
-            loop_interface->RunTic(set->cmds, set->ingame);
-	    gametic++;
-
-	    // modify command for duplicated tics
-
-            TicdupSquash(set);
-	}
 	//printf("last net uupdate...\n");
 	NetUpdate ();	// check for new console commands
     }
@@ -825,3 +1168,103 @@ void D_RegisterLoopCallbacks(loop_interface_t *i)
 {
     loop_interface = i;
 }
+
+//
+// D_SimulateNetGame
+// Makes a tic every 1/35 s of a simulated clock with BuildTiccmd,
+// as NetUpdate does, and runs what it can as TryRunTics does with
+// the Vanilla sync.  Also counts the tics that could not be made
+// for being too far ahead, and the average time from making a tic
+// to first running it.
+//
+
+int D_SimulateNetGame(ticcmd_t *cmds, int numtics, unsigned int *sums,
+                      int *stalls, int *lagms, int *reruns)
+{
+    int maketime[BACKUPTICS];
+    ticcmd_t cmd;
+    int simtime;
+    int endtime;
+    int nowtic;
+    int lasttic;
+    int firsttic;
+    int lagtotal;
+    int i;
+
+    NET_SerialSimulateConnect(cmds, numtics);
+
+    localplayer = NET_SerialConsolePlayer();
+
+    for (i = 0; i < NET_MAXPLAYERS; ++i)
+    {
+        local_playeringame[i] = i < 2;
+    }
+
+    ticdup = 1;
+    new_sync = false;
+    gametic = maketic = recvtic = confirmtic = 0;
+    predictstalled = false;
+    rollbacks = reruntics = 0;
+    simsums = sums;
+    simnumtics = numtics;
+
+    *stalls = 0;
+    lagtotal = 0;
+    lasttic = 0;
+    firsttic = 0;
+
+    // give up on a link too lossy to ever get to the end
+    endtime = (numtics * 1000 / TICRATE) * 10 + 60 * 1000;
+
+    for (simtime = 0; confirmtic < numtics && simtime < endtime; ++simtime)
+    {
+        NET_SerialSimulateTime(simtime);
+
+        nowtic = simtime * TICRATE / 1000;
+
+        for ( ; lasttic < nowtic && maketic < numtics; ++lasttic)
+        {
+            if (maketic - gametic >= 5)
+            {
+                ++*stalls;
+                continue;
+            }
+
+            maketime[maketic % BACKUPTICS] = simtime;
+
+            memset(&cmd, 0, sizeof(ticcmd_t));
+            loop_interface->BuildTiccmd(&cmd, maketic);
+            StoreNewTic(&cmd);
+        }
+
+        NET_SerialRun();
+
+        while (gametic < GetLowTic())
+        {
+            CheckPredictions();
+
+            if (!RunGameTic(GetLowTic()))
+            {
+                break;
+            }
+
+            // tics run again do not count
+            if (gametic > firsttic)
+            {
+                lagtotal += simtime - maketime[firsttic % BACKUPTICS];
+                firsttic = gametic;
+            }
+        }
+
+        CheckPredictions();
+    }
+
+    NET_SerialDisconnect();
+
+    simsums = NULL;
+
+    *lagms = firsttic > 0 ? lagtotal / firsttic : 0;
+    *reruns = reruntics;
+
+    return confirmtic;
+}
@@ -46,8 +46,31 @@ typedef struct
     // Run the menu (runs independently of the game).
 
     void (*RunMenu)();
+
+    // Keep the game state as it is before the specified tic, to
+    // come back to if the tic is run on wrongly guessed input.
+    // Returns false if it cannot be brought back.
+
+    boolean (*SaveTic)(int tic);
+
+    // Put the game state back to how it was before the specified tic.
+
+    void (*RestoreTic)(int tic);
+
+    // Given the last ticcmd received from a player, fill in the
+    // specified ticcmd_t structure with a guess at their next.
+
+    void (*PredictTiccmd)(ticcmd_t *cmd, int player, int tic);
+
+    // Hash the game state, to check tics run more than once.
+
+    unsigned int (*StateChecksum)(void);
 } loop_interface_t;
 
+// Most tics the game can run ahead of the other players.
+
+#define MAXPREDICTTICS 16
+
 // Register callback functions for the main loop code to use.
 void D_RegisterLoopCallbacks(loop_interface_t *i);
 
@@ -74,7 +97,23 @@ boolean D_InitNetGame(net_connect_data_t *connect_data);
 void D_StartNetGame(net_gamesettings_t *settings,
                     netgame_startup_callback_t callback);
 
+// Invoked by the network code when a complete set of ticcmds is
+// available.
+
+void D_ReceiveTic(ticcmd_t *ticcmds, boolean *players_mask);
+
+// Play a two player game against the stand-in at the other end of
+// a simulated serial link, which plays cmds.  Fills sums with the
+// checksum of the game after each tic, once the tic has run on the
+// real ticcmds.  Returns the number of tics that got that far.
+
+int D_SimulateNetGame(ticcmd_t *cmds, int numtics, unsigned int *sums,
+                      int *stalls, int *lagms, int *reruns);
+
 extern boolean singletics;
+extern int uncapped_framerate;
+extern int predict_tics;
+extern uint64_t ticcycles;
 extern int gametic, ticdup;
 
 #endif
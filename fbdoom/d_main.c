@@ -58,7 +58,10 @@
 #include "i_timer.h"
 #include "i_video.h"
 
+#include "g_demorec.h"
+#include "g_demoseek.h"
 #include "g_game.h"
+#include "g_rewind.h"
 
 #include "hu_stuff.h"
 #include "wi_stuff.h"
@@ -67,13 +70,16 @@
 #include "net_client.h"
 #include "net_dedicated.h"
 #include "net_query.h"
+#include "net_serial.h"
 
 #include "p_setup.h"
 #include "r_local.h"
 #include "statdump.h"
 
 
+#include "d_govern.h"
 #include "d_main.h"
+#include "d_sim.h"
 
 //
 // D-DoomLoop()
@@ -99,6 +105,7 @@ boolean		devparm;	// started game with -devparm
 boolean         nomonsters;	// checkparm of -nomonsters
 boolean         respawnparm;	// checkparm of -respawn
 boolean         fastparm;	// checkparm of -fast
+boolean         vanillaoverruns;	// unless -nooverruns
 
 //extern int soundVolume;
 //extern  int	sfxVolume;
@@ -154,6 +161,26 @@ void D_ProcessEvents (void)
 }
 
 
+//
+// D_FractionalTic
+// How far the clock is into the next tic, for the renderer to
+// interpolate by.  FRACUNIT whenever the play simulation is
+// not running at its own pace.
+//
+static fixed_t D_FractionalTic (void)
+{
+    int		ms;
+
+    if (!uncapped_framerate || singletics || paused
+     || (menuactive && !netgame && !demoplayback))
+    {
+	return FRACUNIT;
+    }
+
+    ms = I_GetTimeMS () % 1000;
+
+    return ((ms * TICRATE) % 1000) * FRACUNIT / 1000;
+}
 
 
 //
@@ -242,7 +269,10 @@ void D_Display (void)
     
     // draw the view directly
     if (gamestate == GS_LEVEL && !automapactive && gametic)
+    {
+	fractionaltic = D_FractionalTic ();
     	R_RenderPlayerView (&players[displayplayer]);
+    }
 
     if (gamestate == GS_LEVEL && gametic)
     	HU_Drawer ();
@@ -373,6 +403,22 @@ void D_BindVariables(void)
     M_BindVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindVariable("vanilla_demo_limit",     &vanilla_demo_limit);
     M_BindVariable("show_endoom",            &show_endoom);
+    M_BindVariable("uncapped_framerate",     &uncapped_framerate);
+    M_BindVariable("govern_target_fps",      &govern_target_fps);
+    M_BindVariable("govern_hysteresis",      &govern_hysteresis);
+    M_BindVariable("fast_savegames",         &fast_savegames);
+    M_BindVariable("rewind_interval",        &rewind_interval);
+    M_BindVariable("rewind_memory",          &rewind_memory);
+    M_BindVariable("demo_keyframe_interval", &demo_keyframe_interval);
+    M_BindVariable("demo_keyframe_memory",   &demo_keyframe_memory);
+    M_BindVariable("demo_stream",            &demo_stream);
+    M_BindVariable("serial_link",            &serial_link);
+    M_BindVariable("serial_baud",            &serial_baud);
+    M_BindVariable("serial_player",          &serial_player);
+    M_BindVariable("serial_latency",         &serial_latency);
+    M_BindVariable("serial_loss",            &serial_loss);
+    M_BindVariable("serial_extratics",       &serial_extratics);
+    M_BindVariable("predict_tics",           &predict_tics);
 
 //    // Multiplayer chat macros
 	printf("macros...\n");
@@ -413,6 +459,10 @@ boolean D_GrabMouseCallback(void)
 //
 void D_DoomLoop (void)
 {
+    uint64_t	start;
+    uint64_t	rendercycles;
+    boolean	drawn;
+
     if (bfgedition &&
         (demorecording || (gameaction == ga_playdemo) || netgame))
     {
@@ -456,10 +506,18 @@ void D_DoomLoop (void)
 		//S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
 
 		// Update display, next frame, with current state.
-		if (screenvisible)
+		drawn = false;
+		rendercycles = 0;
+
+		if (screenvisible && !G_DemoSkipFrame () && !D_GovernSkipFrame ())
 		{
+			start = I_GetCycles ();
 			D_Display ();
+			rendercycles = I_GetCycles () - start;
+			drawn = true;
 		}
+
+		D_GovernFrame (drawn, rendercycles);
     }
 }
 
@@ -1167,7 +1225,7 @@ void D_DoomMain (void)
 {
     int p;
     char file[256];
-    char demolumpname[9];
+    char demolumpname[9] = "";
 #if ORIGCODE
     int numiwadlumps;
 #endif
@@ -1257,6 +1315,15 @@ void D_DoomMain (void)
 	printf("checking respawn\n");
     respawnparm = M_CheckParm ("-respawn");
 
+    //!
+    // @category compat
+    //
+    // Don't emulate the memory overwritten by intercepts and
+    // spechit overruns.  Vanilla demos that hit them will desync.
+    //
+
+    vanillaoverruns = !M_CheckParm ("-nooverruns");
+
     //!
     // @vanilla
     //
@@ -1816,6 +1883,10 @@ void D_DoomMain (void)
 		autostart = true;
     }
 
+#ifdef HEADLESS_SIM
+    D_RunSimulation (demolumpname);  // never returns
+#endif
+
     p = M_CheckParmWithArgs("-playdemo", 1);
     if (p)
     {
@@ -1833,8 +1904,7 @@ void D_DoomMain (void)
 
     if (startloadgame >= 0)
     {
-        M_StringCopy(file, P_SaveGameFile(startloadgame), sizeof(file));
-        G_LoadGame(file);
+        G_LoadGameSlot(startloadgame);
     }
 
     if (gameaction != ga_loadgame )
@@ -44,6 +44,7 @@ void D_StartTitle (void);
 //
 
 extern  gameaction_t    gameaction;
+extern  boolean         advancedemo;
 
 
 #endif
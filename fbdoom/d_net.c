@@ -28,9 +28,12 @@
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_video.h"
+#include "g_demoseek.h"
 #include "g_game.h"
+#include "g_predict.h"
 #include "doomdef.h"
 #include "doomstat.h"
+#include "p_tick.h"
 #include "w_checksum.h"
 #include "w_wad.h"
 
@@ -72,6 +75,7 @@ static void RunTic(ticcmd_t *cmds, boolean *ingame)
 {
     extern boolean advancedemo;
     unsigned int i;
+    int tics;
 
     // Check for player quits.
 
@@ -92,14 +96,23 @@ static void RunTic(ticcmd_t *cmds, boolean *ingame)
         D_DoAdvanceDemo ();
 
 	//printf("g ticker\n");
-    G_Ticker ();
+
+    // a demo being reviewed can run several tics here, or none
+    for (tics = G_DemoTics (); tics > 0; --tics)
+    {
+        G_Ticker ();
+    }
 }
 
 static loop_interface_t doom_loop_interface = {
     D_ProcessEvents,
     G_BuildTiccmd,
     RunTic,
-    M_Ticker
+    M_Ticker,
+    G_SaveTic,
+    G_RestoreTic,
+    G_PredictTiccmd,
+    P_StateChecksum
 };
 
 
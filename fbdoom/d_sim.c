@@ -0,0 +1,491 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Headless simulation.  Plays demo lumps from the mapped WAD
+//	through G_Ticker with no video, input or palette I/O, and
+//	prints a state checksum for every tic, so that batch runs
+//	catch both desyncs and play simulation slowdowns.  One
+//	demo is played beforehand in a zone cut down to
+//	SIM_LOWMEM_MB, fetching its textures as if drawn, and
+//	must come out the same; its peak zone use is printed.  The
+//	commands played are then sent down a simulated serial link,
+//	to see what it costs in bytes and in stalls, and played as
+//	a two player game across it, once in lockstep and once
+//	running ahead on predicted commands, which must come out
+//	the same tic for tic.
+//
+
+#include "stdio.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "d_loop.h"
+#include "d_main.h"
+#include "d_sim.h"
+#include "g_game.h"
+#include "g_predict.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_random.h"
+#include "net_serial.h"
+#include "p_tick.h"
+#include "r_data.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+// Core clock of the board, used to turn cycle counts into
+// tics per second.  Set it to match with -DSIM_CLOCK_MHZ=n,
+// or with -DCLOCK_MHZ=n for the whole game.
+
+#ifndef SIM_CLOCK_MHZ
+#define SIM_CLOCK_MHZ CLOCK_MHZ
+#endif
+
+// Zone size of the low-memory check, as a board built with
+// -DDEFAULT_RAM=n would have.  Set it with -DSIM_LOWMEM_MB=n.
+
+#ifndef SIM_LOWMEM_MB
+#define SIM_LOWMEM_MB 3
+#endif
+
+// Tics at the start of each demo sent down the simulated link.
+
+#define SIM_LINKTICS (TICRATE * 60 * 2)
+
+static char *simdemos[] =
+{
+    "DEMO1", "DEMO2", "DEMO3", "DEMO4",
+};
+
+// Tics the predicted game runs ahead when predict_tics is 0.
+
+#define SIM_PREDICTTICS 8
+
+static ticcmd_t *linkcmds;
+
+// Checksums of the link game after each tic: in lockstep, then
+// predicted.
+
+static unsigned int *locksums;
+static unsigned int *predictsums;
+
+extern byte consistancy[MAXPLAYERS][BACKUPTICS];
+
+// The demo played in a low-memory zone, and what it came to.
+
+static char *lowname;
+static int lowtics;
+static unsigned int lowsum;
+
+// Set while the low-memory check plays, to fetch the level's
+// textures as drawing them would.
+
+static boolean lowmemory;
+
+//
+// D_KeepLinkTic
+// Keeps the command the console player ran a tic with, and the
+// consistancy check a netgame would have sent along with it.
+//
+static void D_KeepLinkTic (int tic)
+{
+    player_t*	player;
+
+    player = &players[consoleplayer];
+
+    linkcmds[tic] = player->cmd;
+
+    if (player->mo)
+	linkcmds[tic].consistancy = player->mo->x;
+    else
+	linkcmds[tic].consistancy = rndindex;
+}
+
+//
+// D_SimulateDemo
+// Runs one demo to its end.  Returns the number of tics run,
+// the combined checksum of every tic in *demosum, and the cycles
+// spent running and checking the tics in *cycles, which leaves
+// out printing them.  Each tic's checksum is printed unless quiet.
+//
+static int D_SimulateDemo (char *name, unsigned int *demosum,
+			   uint64_t *cycles, boolean quiet)
+{
+    unsigned int	sum;
+    uint64_t		start;
+    int			tics;
+
+    G_DeferedPlayDemo (name);
+
+    tics = 0;
+    *demosum = 0;
+    *cycles = 0;
+
+    do
+    {
+	start = I_GetCycles ();
+	G_Ticker ();
+	*cycles += I_GetCycles () - start;
+
+	gametic++;
+	tics++;
+
+	if (tics <= SIM_LINKTICS)
+	    D_KeepLinkTic (tics - 1);
+
+	start = I_GetCycles ();
+	sum = P_StateChecksum ();
+	*cycles += I_GetCycles () - start;
+
+	*demosum = (*demosum ^ sum) * 16777619u;
+
+	if (!quiet)
+	    printf ("%s %i %08x\n", name, tics, sum);
+
+	// as the level is entered, then every second, so that
+	// relieved lookups and purged composites are built again
+	if (lowmemory && gamestate == GS_LEVEL && leveltime % TICRATE == 1)
+	    R_CacheLevelTextures ();
+    } while (demoplayback);
+
+    // G_CheckDemoStatus asks for the next attract demo;
+    // we pick our own.
+    advancedemo = false;
+
+    return tics;
+}
+
+//
+// D_ReportLink
+// Sends the first tics of the last demo down the simulated
+// serial link, and prints what it cost.
+//
+static void D_ReportLink (char *name, int tics)
+{
+    int		bytes;
+    int		stalls;
+
+    if (tics > SIM_LINKTICS)
+	tics = SIM_LINKTICS;
+
+    NET_SerialSimulate (linkcmds, tics, &bytes, &stalls);
+
+    // per tic at each end
+    bytes = bytes * 100 / (tics * 2);
+
+    printf ("%s: link %i ms, %i%% lost, %i extra tics: %i.%02i bytes/tic, "
+	    "%i of %i tics stalled\n", name, serial_latency, serial_loss,
+	    serial_extratics, bytes / 100, bytes % 100, stalls, tics * 2);
+}
+
+//
+// D_LinkTiccmd
+// This end of the link game plays the first half of the kept
+// commands, checked the way G_BuildTiccmd checks them.
+//
+static void D_LinkTiccmd (ticcmd_t *cmd, int maketic)
+{
+    *cmd = linkcmds[maketic];
+    cmd->consistancy = consistancy[consoleplayer][maketic % BACKUPTICS];
+}
+
+//
+// D_RunLinkTic
+//
+static void D_RunLinkTic (ticcmd_t *cmds, boolean *ingame)
+{
+    netcmds = cmds;
+    G_Ticker ();
+}
+
+static void D_NoLinkEvents (void)
+{
+}
+
+static loop_interface_t link_loop_interface =
+{
+    D_NoLinkEvents,
+    D_LinkTiccmd,
+    D_RunLinkTic,
+    D_NoLinkEvents,
+    G_SaveTic,
+    G_RestoreTic,
+    G_PredictTiccmd,
+    P_StateChecksum
+};
+
+//
+// D_StartLinkGame
+// A two player cooperative game of the level the last demo was
+// on, from its start.
+//
+static void D_StartLinkGame (void)
+{
+    int		i;
+
+    netgame = true;
+    deathmatch = 0;
+    consoleplayer = displayplayer = 0;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+	playeringame[i] = i < 2;
+
+    precache = false;
+    G_InitNew (gameskill, gameepisode, gamemap);
+    precache = true;
+
+    gameaction = ga_nothing;
+}
+
+//
+// D_PlayLinkGame
+// Returns the tics confirmed.
+//
+static int D_PlayLinkGame (int tics, int predict, unsigned int *sums,
+			   int *stalls, int *lagms, int *reruns)
+{
+    int		saved;
+    int		confirmed;
+
+    saved = predict_tics;
+    predict_tics = predict;
+
+    D_StartLinkGame ();
+    confirmed = D_SimulateNetGame (linkcmds, tics, sums, stalls, lagms,
+				   reruns);
+
+    predict_tics = saved;
+
+    return confirmed;
+}
+
+//
+// D_ReportPrediction
+// Plays the first tics of the last demo as a two player game
+// down the simulated serial link, first in lockstep and then
+// running ahead on predicted commands, and checks every tic
+// comes out the same both ways.
+//
+static void D_ReportPrediction (char *name, int tics)
+{
+    int		predict;
+    int		lockstalls, predictstalls;
+    int		locklag, predictlag;
+    int		reruns;
+    int		confirmed;
+    int		i;
+
+    if (tics > SIM_LINKTICS)
+	tics = SIM_LINKTICS;
+
+    if (tics < 2)
+	return;
+
+    // the link game has no pauses, saves or chat
+    for (i=0 ; i<tics ; i++)
+    {
+	if (linkcmds[i].buttons & BT_SPECIAL)
+	    linkcmds[i].buttons = 0;
+
+	linkcmds[i].chatchar = 0;
+    }
+
+    predict = predict_tics > 0 ? predict_tics : SIM_PREDICTTICS;
+
+    // the attract loop runs the demos by calling G_Ticker
+    // itself, so this need not be put back
+    D_RegisterLoopCallbacks (&link_loop_interface);
+
+    confirmed = D_PlayLinkGame (tics, 0, locksums,
+				&lockstalls, &locklag, &reruns);
+
+    if (D_PlayLinkGame (tics, predict, predictsums,
+			&predictstalls, &predictlag, &reruns) < confirmed)
+    {
+	I_Error ("D_ReportPrediction: the predicted game stopped short");
+    }
+
+    for (i=0 ; i<confirmed ; i++)
+    {
+	if (predictsums[i] != locksums[i])
+	{
+	    I_Error ("D_ReportPrediction: tic %i came out %08x predicted, "
+		     "%08x in lockstep", i, predictsums[i], locksums[i]);
+	}
+    }
+
+    printf ("%s: %i tics predicted ahead: %i ms lag, %i tics stalled; "
+	    "in lockstep %i ms, %i; %i tics run again, %i checked\n",
+	    name, predict, predictlag, predictstalls, locklag, lockstalls,
+	    reruns, confirmed);
+}
+
+//
+// D_FindLowMemoryDemo
+// The low-memory check plays the named demo, or else the first
+// one of the first episode.
+//
+static char *D_FindLowMemoryDemo (char *name)
+{
+    byte*	demo;
+    int		episode;
+    int		i;
+
+    if (name[0] != '\0')
+	return name;
+
+    for (i=0 ; i<arrlen(simdemos) ; i++)
+    {
+	if (W_CheckNumForName (simdemos[i]) < 0)
+	    continue;
+
+	// after the version and the skill
+	demo = W_CacheLumpName (simdemos[i], PU_STATIC);
+	episode = demo[2];
+	W_ReleaseLumpName (simdemos[i]);
+
+	if (episode == 1)
+	    return simdemos[i];
+    }
+
+    return NULL;
+}
+
+//
+// D_SimulateLowMemory
+// Plays a demo with all but SIM_LOWMEM_MB of the zone taken up,
+// so that it is loaded and played with caches purged and lookups
+// dropped as on a small board, and prints the most of the rest
+// it took.  D_ReportDemo checks the run with all of the zone
+// against it.
+//
+static void D_SimulateLowMemory (char *name)
+{
+    void*	reserved;
+    uint64_t	cycles;
+    int		size;
+    int		reservedsize;
+
+    lowname = D_FindLowMemoryDemo (name);
+
+    if (lowname == NULL)
+	return;
+
+    size = Z_ZoneSize () - SIM_LOWMEM_MB * 1024 * 1024;
+
+    // keep back a little for the block headers
+    if (size <= 0 || size > Z_FreeMemory () - 64 * 1024)
+    {
+	printf ("%s: the zone is too full to check in %i MiB\n",
+		lowname, SIM_LOWMEM_MB);
+	lowname = NULL;
+	return;
+    }
+
+    // the filler block is held all through, so it is taken off
+    Z_ResetPeakMemory ();
+    reservedsize = Z_PeakMemory ();
+    reserved = Z_Malloc (size, PU_STATIC, NULL);
+    reservedsize = Z_PeakMemory () - reservedsize;
+
+    lowmemory = true;
+    lowtics = D_SimulateDemo (lowname, &lowsum, &cycles, true);
+    lowmemory = false;
+
+    printf ("%s: zone peak %i KiB in %i MiB\n", lowname,
+	    (Z_PeakMemory () - reservedsize) / 1024, SIM_LOWMEM_MB);
+
+    Z_Free (reserved);
+}
+
+//
+// D_ReportDemo
+// Plays one demo and prints its totals.  Returns the tics run.
+//
+static int D_ReportDemo (char *name)
+{
+    unsigned int	demosum;
+    uint64_t		cycles;
+    int			tics;
+
+    tics = D_SimulateDemo (name, &demosum, &cycles, false);
+
+    if (cycles == 0)
+	cycles = 1;
+
+    printf ("%s: %i tics, %llu cycles, %i tics/s, checksum %08x\n",
+	    name, tics, (unsigned long long) cycles,
+	    (int) (((uint64_t) tics * SIM_CLOCK_MHZ * 1000000) / cycles),
+	    demosum);
+
+    if (name == lowname)
+    {
+	if (tics != lowtics || demosum != lowsum)
+	{
+	    I_Error ("D_ReportDemo: %s came out %08x in %i tics, but %08x "
+		     "in %i tics in %i MiB", name, demosum, tics, lowsum,
+		     lowtics, SIM_LOWMEM_MB);
+	}
+
+	printf ("%s: the same in %i MiB\n", name, SIM_LOWMEM_MB);
+    }
+
+    D_ReportLink (name, tics);
+    D_ReportPrediction (name, tics);
+
+    return tics;
+}
+
+//
+// D_RunSimulation
+// Plays the named demo lump, or every DEMOn lump in the WAD
+// if name is empty, then stops.  Never returns.
+//
+void D_RunSimulation (char *name)
+{
+    int		totaltics;
+    int		numdemos;
+    int		i;
+
+    nodrawers = true;
+    linkcmds = Z_Malloc (SIM_LINKTICS * sizeof(*linkcmds), PU_STATIC, NULL);
+    locksums = Z_Malloc (SIM_LINKTICS * sizeof(*locksums), PU_STATIC, NULL);
+    predictsums = Z_Malloc (SIM_LINKTICS * sizeof(*predictsums), PU_STATIC,
+			    NULL);
+    totaltics = 0;
+    numdemos = 0;
+
+    // before any level takes up the zone
+    D_SimulateLowMemory (name);
+
+    if (name[0] != '\0')
+    {
+	totaltics += D_ReportDemo (name);
+	numdemos++;
+    }
+    else
+    {
+	for (i=0 ; i<arrlen(simdemos) ; i++)
+	{
+	    if (W_CheckNumForName (simdemos[i]) < 0)
+		continue;
+
+	    totaltics += D_ReportDemo (simdemos[i]);
+	    numdemos++;
+	}
+    }
+
+    I_Error ("D_RunSimulation: %i demos, %i tics", numdemos, totaltics);
+}
@@ -0,0 +1,27 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Headless demo simulation.
+//
+
+
+#ifndef __D_SIM__
+#define __D_SIM__
+
+// Plays demo lumps with no drawer, printing a checksum per tic,
+// what their commands cost down a serial link, and what playing
+// them across it ahead of the other end saves.  Never returns.
+void D_RunSimulation (char *name);
+
+#endif
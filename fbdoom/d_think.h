@@ -60,9 +60,25 @@ typedef struct thinker_s
     struct thinker_s*	prev;
     struct thinker_s*	next;
     think_t		function;
+
+    // Order of addition, which is also the order in the list.
+    // Sleeping thinkers are linked back in by it.
+    int			seq;
     
 } thinker_t;
 
 
+// A thinker taken off the list until a countdown runs out
+// (see P_SleepThinker).
+typedef struct sleeper_s
+{
+    struct sleeper_s*	next;		// in its timer wheel slot
+    thinker_t*		thinker;
+    int*		count;		// the countdown it skips
+    int			wake;		// leveltime it runs again
+    
+} sleeper_t;
+
+
 
 #endif
@@ -49,6 +49,10 @@ extern  boolean	fastparm;	// checkparm of -fast
 
 extern  boolean	devparm;	// DEBUG: launched with -devparm
 
+// Emulate the memory vanilla trashed when the intercepts and
+// spechit lists overflowed.  Demos recorded with vanilla need it.
+extern  boolean	vanillaoverruns;	// unless -nooverruns
+
 
 // -----------------------------------------------------
 // Game Mode - identify IWAD as shareware, retail etc.
@@ -259,6 +263,10 @@ extern  gamestate_t     wipegamestate;
 
 extern  int             mouseSensitivity;
 
+// Player corpses, oldest removed first once the queue is full.
+#define BODYQUESIZE	32
+
+extern  mobj_t*         bodyque[BODYQUESIZE];
 extern  int             bodyqueslot;
 
 
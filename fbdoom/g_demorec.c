@@ -0,0 +1,314 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Chunked demo recorder.  A demo being recorded is written to
+//	fixed-size chunks, and a new one is started when one fills,
+//	so nothing is ever copied to make room.  Finished chunks can
+//	be kept for writing out at the end, sent down the console
+//	UART a little every tic, or copied into a reserved memory
+//	window that survives a warm reset.
+//
+
+#include "stdio.h"
+#include "string.h"
+
+#include "doomdef.h"
+
+#include "g_demorec.h"
+#include "i_system.h"
+#include "z_zone.h"
+
+// Bytes in a chunk.  A tic of a four player longtics demo is
+// 20 bytes, and the recorder wants 16 spare.
+
+#define DEMOCHUNKSIZE		(16*1024)
+
+// Bytes sent down the UART per tic, and per line.
+
+#define DEMO_STREAMBYTES	128
+#define DEMO_LINEBYTES		64
+
+#define DEMOWINDOW_MAGIC	0x4d444246	// "FBDM"
+
+typedef struct demochunk_s
+{
+    struct demochunk_s*	next;
+    int			length;
+    int			sent;
+    byte		data[DEMOCHUNKSIZE];
+} demochunk_t;
+
+// Header of the reserved demo window.  The length is only
+// ever updated after the bytes it covers are in place.
+
+typedef struct
+{
+    unsigned int	magic;
+    int			length;
+    int			reserved[2];
+} demowindow_t;
+
+extern byte*	demobuffer;
+extern byte*	demo_p;
+extern byte*	demoend;
+
+int demo_stream = demostream_file;
+
+// Chunks not yet sent out, oldest first.  The last is the one
+// being written.
+
+static demochunk_t*	chunks;
+static demochunk_t*	lastchunk;
+
+static int		chunkslength;
+static int		chunksequence;
+
+static demowindow_t*	window;
+static int		windowsize;
+static boolean		windowfull;
+
+static char		hexdigits[] = "0123456789abcdef";
+
+//
+// G_NewDemoChunk
+//
+static void G_NewDemoChunk (void)
+{
+    demochunk_t*	chunk;
+
+    chunk = Z_Malloc (sizeof(*chunk), PU_STATIC, NULL);
+    chunk->next = NULL;
+    chunk->length = 0;
+    chunk->sent = 0;
+
+    if (lastchunk)
+	lastchunk->next = chunk;
+    else
+	chunks = chunk;
+
+    lastchunk = chunk;
+
+    demobuffer = demo_p = chunk->data;
+    demoend = chunk->data + DEMOCHUNKSIZE;
+}
+
+//
+// G_StartDemoChunks
+//
+void G_StartDemoChunks (void)
+{
+    chunks = lastchunk = NULL;
+    chunkslength = 0;
+    chunksequence = 0;
+
+    if (demo_stream == demostream_window)
+    {
+	window = (demowindow_t *) I_DemoWindowBase (&windowsize);
+	windowfull = false;
+
+	if (windowsize < (int) sizeof(*window))
+	{
+	    printf ("G_StartDemoChunks: no demo window, keeping the "
+		    "demo for a file\n");
+	    demo_stream = demostream_file;
+	}
+	else
+	{
+	    window->magic = DEMOWINDOW_MAGIC;
+	    window->length = 0;
+	    window->reserved[0] = window->reserved[1] = 0;
+	}
+    }
+
+    G_NewDemoChunk ();
+}
+
+//
+// G_SendDemoLine
+// One line of a chunk as hex, for a host on the console to
+// pick out of the log and put back together.
+//
+static void G_SendDemoLine (byte *data, int length)
+{
+    char	line[DEMO_LINEBYTES*2 + 1];
+    int		i;
+
+    for (i=0 ; i<length ; i++)
+    {
+	line[i*2] = hexdigits[data[i] >> 4];
+	line[i*2+1] = hexdigits[data[i] & 15];
+    }
+
+    line[length*2] = '\0';
+
+    printf ("DEMO %i %s\n", chunksequence++, line);
+}
+
+//
+// G_SendDemoChunk
+// Sends up to max bytes of a chunk.  Returns the bytes sent.
+//
+static int G_SendDemoChunk (demochunk_t *chunk, int max)
+{
+    int		sent;
+    int		length;
+
+    sent = 0;
+
+    while (sent < max && chunk->sent < chunk->length)
+    {
+	length = chunk->length - chunk->sent;
+
+	if (length > DEMO_LINEBYTES)
+	    length = DEMO_LINEBYTES;
+
+	G_SendDemoLine (chunk->data + chunk->sent, length);
+	chunk->sent += length;
+	sent += length;
+    }
+
+    return sent;
+}
+
+//
+// G_CopyDemoChunk
+// Appends a chunk to the demo window.
+//
+static void G_CopyDemoChunk (demochunk_t *chunk)
+{
+    byte*	dest;
+
+    if (windowfull)
+	return;
+
+    if (window->length + chunk->length
+	> windowsize - (int) sizeof(*window))
+    {
+	printf ("G_CopyDemoChunk: demo window full at %i bytes\n",
+		window->length);
+	windowfull = true;
+	return;
+    }
+
+    dest = (byte *) (window + 1) + window->length;
+    memcpy (dest, chunk->data, chunk->length);
+    window->length += chunk->length;
+}
+
+//
+// G_FreeSentChunks
+//
+static void G_FreeSentChunks (void)
+{
+    demochunk_t*	chunk;
+
+    while (chunks != lastchunk && chunks->sent == chunks->length)
+    {
+	chunk = chunks;
+	chunks = chunk->next;
+	Z_Free (chunk);
+    }
+}
+
+//
+// G_NextDemoChunk
+//
+void G_NextDemoChunk (void)
+{
+    lastchunk->length = demo_p - demobuffer;
+    chunkslength += lastchunk->length;
+
+    if (demo_stream == demostream_window)
+    {
+	G_CopyDemoChunk (lastchunk);
+	lastchunk->sent = lastchunk->length;
+    }
+
+    G_NewDemoChunk ();
+    G_FreeSentChunks ();
+}
+
+//
+// G_DemoChunksLength
+//
+int G_DemoChunksLength (void)
+{
+    return chunkslength + (demo_p - demobuffer);
+}
+
+//
+// G_DemoChunksTicker
+// Sends a little of the finished chunks down the UART, so that
+// a long demo goes out while it is recorded without a pause.
+//
+void G_DemoChunksTicker (void)
+{
+    if (demo_stream != demostream_uart || chunks == lastchunk)
+	return;
+
+    G_SendDemoChunk (chunks, DEMO_STREAMBYTES);
+    G_FreeSentChunks ();
+}
+
+//
+// G_FinishDemoChunks
+// Demo_p is just past the end marker.
+//
+void G_FinishDemoChunks (char *filename)
+{
+    demochunk_t*	chunk;
+    FILE*		handle;
+
+    lastchunk->length = demo_p - demobuffer;
+    chunkslength += lastchunk->length;
+
+    switch (demo_stream)
+    {
+      case demostream_uart:
+	for (chunk = chunks ; chunk ; chunk = chunk->next)
+	    G_SendDemoChunk (chunk, chunk->length);
+
+	printf ("DEMO END %s %i\n", filename, chunkslength);
+	break;
+
+      case demostream_window:
+	G_CopyDemoChunk (lastchunk);
+	break;
+
+      default:
+	handle = fopen (filename, "wb");
+
+	if (handle == NULL)
+	{
+	    printf ("G_FinishDemoChunks: can't write %s\n", filename);
+	    break;
+	}
+
+	for (chunk = chunks ; chunk ; chunk = chunk->next)
+	    fwrite (chunk->data, 1, chunk->length, handle);
+
+	fclose (handle);
+	break;
+    }
+
+    while (chunks)
+    {
+	chunk = chunks;
+	chunks = chunk->next;
+	Z_Free (chunk);
+    }
+
+    lastchunk = NULL;
+    demobuffer = demo_p = demoend = NULL;
+}
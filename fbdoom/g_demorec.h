@@ -0,0 +1,52 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Chunked demo recorder.
+//
+
+
+#ifndef __G_DEMOREC__
+#define __G_DEMOREC__
+
+#include "doomtype.h"
+
+// Where finished chunks of a demo being recorded go.
+
+typedef enum
+{
+    demostream_file,	// kept, and written to the file at the end
+    demostream_uart,	// sent down the console UART as they fill
+    demostream_window	// copied into the reserved demo window
+
+} demostream_t;
+
+extern int demo_stream;
+
+// Starts a demo in a new chunk; demobuffer, demo_p and
+// demoend then point into it.
+void G_StartDemoChunks (void);
+
+// Closes the chunk demo_p is in and moves on to a new one.
+void G_NextDemoChunk (void);
+
+// Bytes recorded so far, in every chunk.
+int G_DemoChunksLength (void);
+
+// Called every tic while recording, to stream chunks out.
+void G_DemoChunksTicker (void);
+
+// Closes the last chunk and sends out everything left.
+void G_FinishDemoChunks (char *filename);
+
+#endif
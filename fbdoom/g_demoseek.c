@@ -0,0 +1,612 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Demo review.  While a demo asked for on the command line
+//	plays, the level is written out in the fast savegame format
+//	every few seconds, together with the random indices and the
+//	place in the demo.  Going back to one of these keyframes and
+//	playing on from it lands on any tic without replaying the
+//	demo from its start.  The demo can also be run several tics
+//	to a frame, or held and stepped a tic at a time.
+//
+
+#include "stdio.h"
+#include "string.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "d_main.h"
+#include "g_demoseek.h"
+#include "g_game.h"
+#include "g_rewind.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_controls.h"
+#include "m_misc.h"
+#include "m_random.h"
+#include "p_saveg.h"
+#include "s_sound.h"
+#include "z_zone.h"
+
+// Most keyframes kept for one demo.
+
+#define MAXKEYFRAMES		1024
+
+// Every this many keyframes is kept whole; the ones between
+// only as their difference from the one before.
+
+#define KEYFRAME_FULL		8
+
+// Size the snapshot buffers start at.
+
+#define KEYFRAME_MINBUFFER	(64*1024)
+
+// Most tics run for one tic of the main loop while seeking.
+
+#define DEMO_SEEKBURST		(TICRATE*30)
+
+// How far the seek keys move.
+
+#define DEMO_SEEKSTEP		(TICRATE*10)
+
+#define DEMO_MAXSPEED		16
+
+// Keyframes taken between reports of their cost.
+
+#define KEYFRAME_REPORT		16
+
+typedef struct
+{
+    byte*	data;
+    int		size;
+    boolean	full;
+
+    // demo tics read before it, and where the next is
+    int		tic;
+    int		demopos;
+
+    int		episode;
+    int		map;
+    int		rndindex;
+    boolean	paused;
+} keyframe_t;
+
+extern byte*	demobuffer;
+extern byte*	demo_p;
+extern boolean	longtics;
+extern boolean	netdemo;
+extern boolean	timingdemo;
+
+int demo_keyframe_interval = 0;
+int demo_keyframe_memory = 4096;
+
+int demotics;
+
+static keyframe_t	keyframes[MAXKEYFRAMES];
+static int		numkeyframes;
+static int		keyframebytes;
+static boolean		keyframesfull;
+
+// The newest keyframe, whole, for the next to be compared to,
+// and room to write and rebuild others.
+
+static byte*		lastkey;
+static byte*		scratch;
+static byte*		restorebuf;
+static byte*		deltabuffer;
+static int		buffersize;
+static int		lastkeysize;
+
+// Tics in the whole demo.
+
+static int		demolength;
+
+static int		seektarget = -1;
+static int		demospeed = 1;
+static boolean		holding;
+static int		steps;
+
+static uint64_t		keyframecycles;
+
+static char		demomessage[40];
+
+//
+// G_DemoReviewing
+//
+static boolean G_DemoReviewing (void)
+{
+    return demo_keyframe_interval > 0
+	&& demoplayback
+	&& singledemo
+	&& !netdemo
+	&& !timingdemo;
+}
+
+//
+// G_GrowKeyframeBuffers
+// Doubles the snapshot buffers, keeping the newest keyframe.
+//
+static void G_GrowKeyframeBuffers (void)
+{
+    byte*	newlastkey;
+
+    buffersize = buffersize ? buffersize * 2 : KEYFRAME_MINBUFFER;
+
+    newlastkey = Z_Malloc (buffersize, PU_STATIC, NULL);
+
+    if (lastkey != NULL)
+    {
+	memcpy (newlastkey, lastkey, lastkeysize);
+	Z_Free (lastkey);
+	Z_Free (scratch);
+	Z_Free (restorebuf);
+	Z_Free (deltabuffer);
+    }
+
+    lastkey = newlastkey;
+    scratch = Z_Malloc (buffersize, PU_STATIC, NULL);
+    restorebuf = Z_Malloc (buffersize, PU_STATIC, NULL);
+    deltabuffer = Z_Malloc (buffersize * 2 + 16, PU_STATIC, NULL);
+}
+
+//
+// G_ClearKeyframes
+//
+static void G_ClearKeyframes (void)
+{
+    int		i;
+
+    for (i=0 ; i<numkeyframes ; i++)
+	Z_Free (keyframes[i].data);
+
+    numkeyframes = 0;
+    keyframebytes = 0;
+    keyframesfull = false;
+    lastkeysize = 0;
+    keyframecycles = 0;
+}
+
+//
+// G_DemoStart
+// Finds the length of the demo, which only ever ends at the
+// start of a tic, and forgets the last one's keyframes.
+//
+void G_DemoStart (void)
+{
+    byte*	p;
+    int		ticsize;
+    int		i;
+
+    G_ClearKeyframes ();
+
+    demotics = 0;
+    seektarget = -1;
+    demospeed = 1;
+    holding = false;
+    steps = 0;
+
+    ticsize = longtics ? 5 : 4;
+
+    for (i=1 ; i<MAXPLAYERS ; i++)
+    {
+	if (playeringame[i])
+	    ticsize += longtics ? 5 : 4;
+    }
+
+    demolength = 0;
+
+    for (p = demo_p ; *p != DEMOMARKER ; p += ticsize)
+	demolength++;
+}
+
+//
+// G_WriteKeySnapshot
+// Writes the level to scratch, and returns its size, or -1 if
+// it will not fit in the memory allowed.
+//
+static int G_WriteKeySnapshot (void)
+{
+    int		size;
+
+    while (1)
+    {
+	if (buffersize == 0)
+	    G_GrowKeyframeBuffers ();
+
+	savegame_error = false;
+
+	P_OpenSaveBuffer (scratch, buffersize);
+	P_ArchiveSnapshot ();
+	size = P_SaveGamePosition ();
+	P_CloseSaveBuffer ();
+
+	if (!savegame_error)
+	    return size;
+
+	if (buffersize * 5 + 16 > demo_keyframe_memory * 1024)
+	    return -1;
+
+	G_GrowKeyframeBuffers ();
+    }
+}
+
+//
+// G_TakeKeyframe
+//
+static void G_TakeKeyframe (void)
+{
+    keyframe_t*	key;
+    keyframe_t*	last;
+    uint64_t	start;
+    byte*	data;
+    byte*	swap;
+    int		size;
+
+    start = I_GetCycles ();
+
+    key = &keyframes[numkeyframes];
+    last = numkeyframes ? &keyframes[numkeyframes-1] : NULL;
+
+    size = G_WriteKeySnapshot ();
+
+    if (size >= 0)
+    {
+	key->full = numkeyframes % KEYFRAME_FULL == 0
+		 || last->episode != gameepisode
+		 || last->map != gamemap;
+
+	if (key->full)
+	{
+	    data = scratch;
+	    key->size = size;
+	}
+	else
+	{
+	    data = deltabuffer;
+	    key->size = G_EncodeDelta (lastkey, lastkeysize, scratch, size,
+				       deltabuffer);
+	}
+    }
+
+    if (size < 0
+	|| keyframebytes + key->size > demo_keyframe_memory * 1024)
+    {
+	printf ("G_TakeKeyframe: keyframes full at tic %i; seeking past "
+		"it plays on from there\n", demotics);
+	keyframesfull = true;
+	return;
+    }
+
+    key->data = Z_Malloc (key->size, PU_STATIC, NULL);
+    memcpy (key->data, data, key->size);
+
+    key->tic = demotics;
+    key->demopos = demo_p - demobuffer;
+    key->episode = gameepisode;
+    key->map = gamemap;
+    key->rndindex = rndindex;
+    key->paused = paused;
+
+    swap = lastkey;
+    lastkey = scratch;
+    scratch = swap;
+    lastkeysize = size;
+
+    keyframebytes += key->size;
+    numkeyframes++;
+
+    keyframecycles += I_GetCycles () - start;
+
+    if (numkeyframes % KEYFRAME_REPORT == 0)
+    {
+	printf ("G_DemoSeek: %i keyframes in %i bytes, %llu cycles each\n",
+		numkeyframes, keyframebytes,
+		(unsigned long long) (keyframecycles / numkeyframes));
+    }
+}
+
+//
+// G_RestoreKeyframe
+// Rebuilds a keyframe from the whole one before it, and puts
+// the game and the demo back to it.
+//
+static void G_RestoreKeyframe (int num)
+{
+    keyframe_t*	key;
+    byte*	swap;
+    int		size;
+    int		i;
+
+    for (i = num ; !keyframes[i].full ; i--)
+	;
+
+    memcpy (restorebuf, keyframes[i].data, keyframes[i].size);
+    size = keyframes[i].size;
+
+    for (i++ ; i <= num ; i++)
+    {
+	size = G_DecodeDelta (restorebuf, keyframes[i].data, scratch);
+
+	swap = restorebuf;
+	restorebuf = scratch;
+	scratch = swap;
+    }
+
+    key = &keyframes[num];
+
+    // the sounds playing come from mobjs about to go
+    S_StopSounds ();
+
+    if (gamestate != GS_LEVEL
+	|| gameepisode != key->episode
+	|| gamemap != key->map)
+    {
+	precache = false;
+	G_InitNew (gameskill, key->episode, key->map);
+	precache = true;
+
+	// G_InitNew starts a game for the player; this one is
+	// still the demo's, as in G_DoPlayDemo
+	usergame = false;
+	demoplayback = true;
+    }
+
+    savegame_error = false;
+
+    P_OpenSaveBuffer (restorebuf, size);
+    P_UnArchiveSnapshot ();
+    P_CloseSaveBuffer ();
+
+    if (savegame_error)
+	I_Error ("G_RestoreKeyframe: bad keyframe");
+
+    rndindex = key->rndindex;
+    paused = key->paused;
+    demo_p = demobuffer + key->demopos;
+    demotics = key->tic;
+}
+
+//
+// G_DemoTicker
+//
+void G_DemoTicker (void)
+{
+    if (!demoplayback)
+	return;
+
+    demotics++;
+
+    if (!G_DemoReviewing ()
+	|| keyframesfull
+	|| numkeyframes == MAXKEYFRAMES
+	|| gamestate != GS_LEVEL
+	|| gameaction != ga_nothing)
+    {
+	return;
+    }
+
+    // only the first pass through the demo adds keyframes
+    if (numkeyframes > 0
+	&& demotics < keyframes[numkeyframes-1].tic + demo_keyframe_interval)
+    {
+	return;
+    }
+
+    G_TakeKeyframe ();
+}
+
+//
+// G_SeekKeyframe
+// Goes to the last keyframe at or before the seek target, if
+// that is closer than playing on from here.
+//
+static void G_SeekKeyframe (void)
+{
+    int		i;
+
+    for (i = numkeyframes-1 ; i >= 0 ; i--)
+    {
+	if (keyframes[i].tic <= seektarget)
+	    break;
+    }
+
+    if (i < 0)
+    {
+	// back before the first keyframe: as near as we can get
+	if (seektarget < demotics)
+	{
+	    if (numkeyframes > 0)
+		G_RestoreKeyframe (0);
+
+	    seektarget = -1;
+	}
+	return;
+    }
+
+    if (seektarget < demotics || keyframes[i].tic > demotics)
+	G_RestoreKeyframe (i);
+}
+
+//
+// G_DemoTics
+//
+int G_DemoTics (void)
+{
+    int		tics;
+
+    if (!G_DemoReviewing ())
+	return 1;
+
+    // leaving the demo for a game needs a tic to run
+    if (gameaction == ga_newgame
+	|| gameaction == ga_loadgame
+	|| gameaction == ga_playdemo)
+    {
+	return 1;
+    }
+
+    if (seektarget >= 0)
+    {
+	G_SeekKeyframe ();
+
+	if (seektarget < 0)
+	    return 0;
+
+	tics = seektarget - demotics;
+
+	if (tics > DEMO_SEEKBURST)
+	    tics = DEMO_SEEKBURST;
+
+	if (tics <= 0)
+	    seektarget = -1;
+
+	return tics > 0 ? tics : 0;
+    }
+
+    if (holding)
+    {
+	if (steps == 0)
+	    return 0;
+
+	steps--;
+	tics = 1;
+    }
+    else
+    {
+	tics = demospeed;
+    }
+
+    // hold at the end, so there is still something to seek in
+    if (tics > demolength - demotics)
+	tics = demolength - demotics;
+
+    return tics;
+}
+
+//
+// G_DemoSkipFrame
+//
+boolean G_DemoSkipFrame (void)
+{
+    return seektarget >= 0 && G_DemoReviewing ();
+}
+
+//
+// G_DemoMessage
+//
+static void G_DemoMessage (char *text, int tic)
+{
+    M_snprintf (demomessage, sizeof(demomessage), "%s %i:%02i.%02i",
+		text, tic / (60*TICRATE), (tic / TICRATE) % 60, tic % TICRATE);
+    players[consoleplayer].message = demomessage;
+}
+
+//
+// G_DemoSeek
+// Goes to a tic of the demo, counted from its start.
+//
+void G_DemoSeek (int tic)
+{
+    if (!G_DemoReviewing ())
+	return;
+
+    if (tic < 0)
+	tic = 0;
+
+    if (tic > demolength)
+	tic = demolength;
+
+    seektarget = tic;
+
+    G_DemoMessage ("seek", tic);
+}
+
+//
+// G_DemoFastForward
+// Plays speed tics for each one of the main loop.
+//
+void G_DemoFastForward (int speed)
+{
+    if (speed < 1)
+	speed = 1;
+
+    if (speed > DEMO_MAXSPEED)
+	speed = DEMO_MAXSPEED;
+
+    demospeed = speed;
+    holding = false;
+    steps = 0;
+}
+
+//
+// G_DemoStep
+// Holds the demo, or if it is held, plays one more tic.
+//
+void G_DemoStep (void)
+{
+    if (!holding)
+    {
+	holding = true;
+	steps = 0;
+    }
+    else
+    {
+	steps++;
+    }
+}
+
+//
+// G_DemoResponder
+//
+boolean G_DemoResponder (event_t* ev)
+{
+    if (!G_DemoReviewing () || ev->type != ev_keydown)
+	return false;
+
+    if (ev->data1 == key_demo_back)
+    {
+	G_DemoSeek ((seektarget >= 0 ? seektarget : demotics) - DEMO_SEEKSTEP);
+	return true;
+    }
+
+    if (ev->data1 == key_demo_ahead)
+    {
+	G_DemoSeek ((seektarget >= 0 ? seektarget : demotics) + DEMO_SEEKSTEP);
+	return true;
+    }
+
+    if (ev->data1 == key_demo_speed)
+    {
+	// 1, 2, 4 ... DEMO_MAXSPEED, then back to 1; the key
+	// also lets a held demo go
+	if (holding)
+	    G_DemoFastForward (1);
+	else
+	    G_DemoFastForward (demospeed == DEMO_MAXSPEED ? 1 : demospeed * 2);
+
+	M_snprintf (demomessage, sizeof(demomessage), "speed x%i", demospeed);
+	players[consoleplayer].message = demomessage;
+	return true;
+    }
+
+    if (ev->data1 == key_demo_step)
+    {
+	G_DemoStep ();
+	G_DemoMessage ("step", demotics + steps);
+	return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,55 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Demo review: seeking, fast-forward and stepping.
+//
+
+
+#ifndef __G_DEMOSEEK__
+#define __G_DEMOSEEK__
+
+#include "doomtype.h"
+#include "d_event.h"
+
+// Tics between keyframes of a demo being reviewed, or 0 to
+// play demos as vanilla does.
+extern int demo_keyframe_interval;
+
+// Kilobytes the keyframes of one demo may use.
+extern int demo_keyframe_memory;
+
+// Tics of the demo read so far.
+extern int demotics;
+
+// Called once a demo has been set up to play.
+void G_DemoStart (void);
+
+// Called at the end of every G_Ticker.
+void G_DemoTicker (void);
+
+// How many tics to run in place of the next one: none while
+// stepping or at the end, several when fast-forwarding or
+// seeking.
+int G_DemoTics (void);
+
+// True if the main loop should not draw this frame.
+boolean G_DemoSkipFrame (void);
+
+boolean G_DemoResponder (event_t* ev);
+
+void G_DemoSeek (int tic);
+void G_DemoFastForward (int speed);
+void G_DemoStep (void);
+
+#endif
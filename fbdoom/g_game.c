@@ -70,7 +70,10 @@
 
 
 
+#include "g_demorec.h"
+#include "g_demoseek.h"
 #include "g_game.h"
+#include "g_rewind.h"
 
 
 #define SAVEGAMESIZE	0x2c000
@@ -222,8 +225,6 @@ static boolean *joybuttons = &joyarray[1];		// allow [-1]
 static int      savegameslot; 
 static char     savedescription[32]; 
  
-#define	BODYQUESIZE	32
-
 mobj_t*		bodyque[BODYQUESIZE]; 
 int		bodyqueslot; 
  
@@ -653,6 +654,7 @@ void G_DoLoadLevel (void)
     } 
 		 
     P_SetupLevel (gameepisode, gamemap, 0, gameskill);    
+    G_ClearRewind ();
     displayplayer = consoleplayer;		// view the guy you are playing    
     gameaction = ga_nothing; 
     Z_CheckHeap ();
@@ -745,6 +747,10 @@ boolean G_Responder (event_t* ev)
 	} while (!playeringame[displayplayer] && displayplayer != consoleplayer); 
 	return true; 
     }
+
+    // seeking and stepping in a demo being reviewed
+    if (G_DemoResponder (ev))
+	return true;
     
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo && 
@@ -806,6 +812,13 @@ boolean G_Responder (event_t* ev)
         next_weapon = 1;
     }
 
+    if (ev->type == ev_keydown && ev->data1 == key_rewind
+     && G_RewindAvailable())
+    {
+        gameaction = ga_rewind;
+        return true;
+    }
+
     switch (ev->type) 
     { 
       case ev_keydown: 
@@ -896,6 +909,9 @@ void G_Ticker (void)
             players[consoleplayer].message = DEH_String("screen shot");
 	    gameaction = ga_nothing; 
 	    break; 
+	  case ga_rewind:
+	    G_DoRewind ();
+	    break;
 	  case ga_nothing: 
 	    break; 
 	} 
@@ -1006,6 +1022,7 @@ void G_Ticker (void)
     { 
       case GS_LEVEL: 
 	P_Ticker (); 
+	G_RewindTicker ();
 	ST_Ticker (); 
 	AM_Ticker (); 
 	HU_Ticker ();            
@@ -1023,6 +1040,11 @@ void G_Ticker (void)
 	D_PageTicker (); 
 	break;
     }        
+
+    G_DemoTicker ();
+
+    if (demorecording)
+	G_DemoChunksTicker ();
 } 
  
  
@@ -1535,12 +1557,39 @@ extern boolean setsizeneeded;
 void R_ExecuteSetViewSize (void);
 
 char	savename[256];
+int	loadgameslot = -1;
 
 void G_LoadGame (char* name) 
 { 
     M_StringCopy(savename, name, sizeof(savename));
+    loadgameslot = -1;
     gameaction = ga_loadgame; 
 } 
+
+//
+// G_LoadGameSlot
+// Loads from a savegame slot in memory, or from the slot's
+// file if there is no memory for slots.
+//
+void G_LoadGameSlot (int slot)
+{
+    G_LoadGame (P_SaveGameFile(slot));
+    loadgameslot = slot;
+}
+
+//
+// G_CloseSaveGame
+//
+static void G_CloseSaveGame (void)
+{
+    if (save_stream != NULL)
+    {
+	fclose (save_stream);
+	save_stream = NULL;
+    }
+
+    P_CloseSaveBuffer ();
+}
  
 #define VERSIONSIZE		16 
 
@@ -1548,21 +1597,31 @@ void G_LoadGame (char* name)
 void G_DoLoadGame (void) 
 {
     int savedleveltime;
+    uint64_t start;
 	 
     gameaction = ga_nothing; 
-	 
-    save_stream = fopen(savename, "rb");
+    start = I_GetCycles ();
 
-    if (save_stream == NULL)
+    if (loadgameslot >= 0 && P_SaveSlotsAvailable())
     {
-    	return;
+	if (!P_OpenSaveSlot(loadgameslot))
+	    return;
+    }
+    else
+    {
+	save_stream = fopen(savename, "rb");
+
+	if (save_stream == NULL)
+	{
+	    return;
+	}
     }
 
     savegame_error = false;
 
     if (!P_ReadSaveGameHeader())
     {
-        fclose(save_stream);
+        G_CloseSaveGame ();
         return;
     }
 
@@ -1574,15 +1633,16 @@ void G_DoLoadGame (void)
     leveltime = savedleveltime;
 
     // dearchive all the modifications
-    P_UnArchivePlayers (); 
-    P_UnArchiveWorld (); 
-    P_UnArchiveThinkers (); 
-    P_UnArchiveSpecials (); 
+    P_UnArchiveGame (); 
  
     if (!P_ReadSaveGameEOF())
 	I_Error ("Bad savegame");
 
-    fclose(save_stream);
+    printf ("G_DoLoadGame: %li bytes in %llu cycles\n",
+	    P_SaveGamePosition(),
+	    (unsigned long long) (I_GetCycles () - start));
+
+    G_CloseSaveGame ();
     
     if (setsizeneeded)
     	R_ExecuteSetViewSize ();
@@ -1607,15 +1667,65 @@ G_SaveGame
     sendsave = true;
 }
 
+//
+// G_DoSaveGameSlot
+// Saves into a slot in the reserved memory window.  The game is
+// written to a spare area first, and only replaces the slot once
+// it is complete, as the file version does with its temp file.
+//
+static void G_DoSaveGameSlot (uint64_t start)
+{
+    P_CreateSaveSlot();
+
+    savegame_error = false;
+
+    P_WriteSaveGameHeader(savedescription);
+ 
+    P_ArchiveGame (); 
+	 
+    P_WriteSaveGameEOF();
+
+    if (savegame_error
+     || (vanilla_savegame_limit && P_SaveGamePosition() > SAVEGAMESIZE))
+    {
+        P_CloseSaveBuffer();
+        I_Error ("Savegame buffer overrun");
+    }
+
+    P_CommitSaveSlot(savegameslot);
+
+    printf ("G_DoSaveGame: slot %i, %li bytes in %llu cycles\n",
+            savegameslot, P_SaveGamePosition(),
+            (unsigned long long) (I_GetCycles () - start));
+
+    P_CloseSaveBuffer();
+
+    gameaction = ga_nothing;
+    M_StringCopy(savedescription, "", sizeof(savedescription));
+
+    players[consoleplayer].message = DEH_String(GGSAVED);
+
+    // draw the pattern into the back screen
+    R_FillBackScreen ();	
+}
+
 void G_DoSaveGame (void) 
 { 
     char *savegame_file;
     char *temp_savegame_file;
     char *recovery_savegame_file;
+    uint64_t start;
 
     recovery_savegame_file = NULL;
     temp_savegame_file = P_TempSaveGameFile();
     savegame_file = P_SaveGameFile(savegameslot);
+    start = I_GetCycles ();
+
+    if (P_SaveSlotsAvailable())
+    {
+        G_DoSaveGameSlot (start);
+        return;
+    }
 
     // Open the savegame file for writing.  We write to a temporary file
     // and then rename it at the end if it was successfully written.
@@ -1640,10 +1750,7 @@ void G_DoSaveGame (void)
 
     P_WriteSaveGameHeader(savedescription);
  
-    P_ArchivePlayers (); 
-    P_ArchiveWorld (); 
-    P_ArchiveThinkers (); 
-    P_ArchiveSpecials (); 
+    P_ArchiveGame (); 
 	 
     P_WriteSaveGameEOF();
 	 
@@ -1658,6 +1765,7 @@ void G_DoSaveGame (void)
     // Finish up, close the savegame file.
 
     fclose(save_stream);
+    save_stream = NULL;
 
     if (recovery_savegame_file != NULL)
     {
@@ -1892,7 +2000,6 @@ G_InitNew
 //
 // DEMO RECORDING 
 // 
-#define DEMOMARKER		0x80
 
 
 void G_ReadDemoTiccmd (ticcmd_t* cmd) 
@@ -1921,37 +2028,9 @@ void G_ReadDemoTiccmd (ticcmd_t* cmd)
     cmd->buttons = (unsigned char)*demo_p++; 
 } 
 
-// Increase the size of the demo buffer to allow unlimited demos
-
-static void IncreaseDemoBuffer(void)
-{
-    int current_length;
-    byte *new_demobuffer;
-    byte *new_demop;
-    int new_length;
-
-    // Find the current size
-
-    current_length = demoend - demobuffer;
-    
-    // Generate a new buffer twice the size
-    new_length = current_length * 2;
-    
-    new_demobuffer = Z_Malloc(new_length, PU_STATIC, 0);
-    new_demop = new_demobuffer + (demo_p - demobuffer);
-
-    // Copy over the old data
-
-    memcpy(new_demobuffer, demobuffer, current_length);
-
-    // Free the old buffer and point the demo pointers at the new buffer.
+// Most bytes a demo may take with vanilla_demo_limit set.
 
-    Z_Free(demobuffer);
-
-    demobuffer = new_demobuffer;
-    demo_p = new_demop;
-    demoend = demobuffer + new_length;
-}
+static int demomaxsize;
 
 void G_WriteDemoTiccmd (ticcmd_t* cmd) 
 { 
@@ -1960,6 +2039,21 @@ void G_WriteDemoTiccmd (ticcmd_t* cmd)
     if (gamekeydown[key_demo_quit])           // press q to end demo recording 
 	G_CheckDemoStatus (); 
 
+    if (demo_p > demoend - 16)
+    {
+        // The chunk is full: carry on in a new one, with
+        // nothing copied.
+
+        G_NextDemoChunk();
+    }
+
+    if (vanilla_demo_limit && G_DemoChunksLength() > demomaxsize - 16)
+    {
+        // no more space 
+        G_CheckDemoStatus (); 
+        return; 
+    }
+
     demo_start = demo_p;
 
     *demo_p++ = cmd->forwardmove; 
@@ -1982,23 +2076,6 @@ void G_WriteDemoTiccmd (ticcmd_t* cmd)
     // reset demo pointer back
     demo_p = demo_start;
 
-    if (demo_p > demoend - 16)
-    {
-        if (vanilla_demo_limit)
-        {
-            // no more space 
-            G_CheckDemoStatus (); 
-            return; 
-        }
-        else
-        {
-            // Vanilla demo limit disabled: unlimited
-            // demo lengths!
-
-            IncreaseDemoBuffer();
-        }
-    } 
-	
     G_ReadDemoTiccmd (cmd);         // make SURE it is exactly the same 
 } 
  
@@ -2030,8 +2107,9 @@ void G_RecordDemo (char *name)
     i = M_CheckParmWithArgs("-maxdemo", 1);
     if (i)
 	maxsize = atoi(myargv[i+1])*1024;
-    demobuffer = Z_Malloc (maxsize,PU_STATIC,NULL); 
-    demoend = demobuffer + maxsize;
+
+    demomaxsize = maxsize;
+    G_StartDemoChunks ();
 	
     demorecording = true; 
 } 
@@ -2212,6 +2290,8 @@ void G_DoPlayDemo (void)
 
     usergame = false; 
     demoplayback = true; 
+
+    G_DemoStart ();
 } 
 
 //
@@ -2262,6 +2342,23 @@ boolean G_CheckDemoStatus (void)
         timingdemo = false;
         demoplayback = false;
 
+#ifdef CYCLEPROFILE
+        printf("BSP traversal: %llu cycles, P_CheckPosition: %llu cycles, "
+               "P_CheckSight: %llu cycles\n",
+               (unsigned long long) bspcycles,
+               (unsigned long long) checkposcycles,
+               (unsigned long long) sightcycles);
+#endif
+        printf("Sight cache: %i hits, %i misses\n",
+               sightcachehits, sightcachemisses);
+        printf("Overruns: %i intercepts, %i spechit\n",
+               interceptoverruns, spechitoverruns);
+#ifdef TRACEBENCH
+        P_BenchTraces ();
+#endif
+        printf("Zone peak: %i of %u bytes\n",
+               Z_PeakMemory(), Z_ZoneSize());
+
 	I_Error ("timed %i gametics in %i realtics (%f fps)",
                  gametic, realtics, fps);
     } 
@@ -2290,8 +2387,7 @@ boolean G_CheckDemoStatus (void)
     if (demorecording) 
     { 
 	*demo_p++ = DEMOMARKER; 
-	M_WriteFile (demoname, demobuffer, demo_p - demobuffer); 
-	Z_Free (demobuffer); 
+	G_FinishDemoChunks (demoname); 
 	demorecording = false; 
 	I_Error ("Demo %s recorded",demoname); 
     } 
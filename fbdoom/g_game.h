@@ -42,6 +42,7 @@ void G_DeferedPlayDemo (char* demo);
 // Can be called by the startup code or M_Responder,
 // calls P_SetupLevel or W_EnterWorld.
 void G_LoadGame (char* name);
+void G_LoadGameSlot (int slot);
 
 void G_DoLoadGame (void);
 
@@ -53,6 +54,9 @@ void G_RecordDemo (char* name);
 
 void G_BeginRecording (void);
 
+// Ends the ticcmds of a demo.
+#define DEMOMARKER		0x80
+
 void G_PlayDemo (char* name);
 void G_TimeDemo (char* name);
 boolean G_CheckDemoStatus (void);
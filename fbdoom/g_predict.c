@@ -0,0 +1,197 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Netgame prediction.  When the game runs ahead of the other
+//	end on guessed commands, the level is written out in the
+//	fast savegame format before each guessed tic, into a ring
+//	of buffers as deep as the game may run ahead.  If a guess
+//	turns out wrong, the loop code brings the level back to
+//	the tic before it and runs the tics again.
+//
+
+#include "stdio.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "d_loop.h"
+#include "d_main.h"
+#include "g_predict.h"
+#include "i_system.h"
+#include "m_random.h"
+#include "p_saveg.h"
+#include "s_sound.h"
+#include "z_zone.h"
+
+// Size a buffer starts at.  It doubles whenever a level does
+// not fit, up to the most one may take.
+
+#define PREDICT_MINBUFFER	(64*1024)
+#define PREDICT_MAXBUFFER	(512*1024)
+
+typedef struct
+{
+    byte*	data;
+    int		capacity;
+    int		size;
+    int		tic;
+    int		rndindex;
+
+    // the checks the tic is about to overwrite with its own,
+    // which it needs again if it is run again
+    byte	consistancy[MAXPLAYERS];
+} predictslot_t;
+
+static predictslot_t	slots[MAXPREDICTTICS];
+
+extern byte consistancy[MAXPLAYERS][BACKUPTICS];
+
+//
+// G_WriteTic
+// Writes the level to a slot, growing its buffer as needed.
+// Returns false if it will not fit.
+//
+static boolean G_WriteTic (predictslot_t *slot)
+{
+    while (1)
+    {
+	if (slot->capacity > 0)
+	{
+	    savegame_error = false;
+
+	    P_OpenSaveBuffer (slot->data, slot->capacity);
+	    P_ArchiveSnapshot ();
+	    slot->size = P_SaveGamePosition ();
+	    P_CloseSaveBuffer ();
+
+	    if (!savegame_error)
+		return true;
+
+	    if (slot->capacity >= PREDICT_MAXBUFFER)
+		return false;
+
+	    Z_Free (slot->data);
+	}
+
+	slot->capacity = slot->capacity ? slot->capacity * 2
+					: PREDICT_MINBUFFER;
+	slot->data = Z_Malloc (slot->capacity, PU_STATIC, NULL);
+    }
+}
+
+//
+// G_SaveTic
+// Only a level being played can be brought back; anything to
+// do with a change of level, a save or a demo has to wait for
+// the real commands.
+//
+boolean G_SaveTic (int tic)
+{
+    static boolean	toobig;
+    predictslot_t*	slot;
+    int			i;
+
+    if (gamestate != GS_LEVEL
+     || gameaction != ga_nothing
+     || paused
+     || demoplayback
+     || demorecording)
+    {
+	return false;
+    }
+
+    slot = &slots[tic % MAXPREDICTTICS];
+    slot->tic = -1;
+
+    if (!G_WriteTic (slot))
+    {
+	if (!toobig)
+	{
+	    printf ("G_SaveTic: level does not fit in %i KiB; not "
+		    "predicting\n", PREDICT_MAXBUFFER / 1024);
+	    toobig = true;
+	}
+
+	return false;
+    }
+
+    slot->tic = tic;
+    slot->rndindex = rndindex;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+	slot->consistancy[i] = consistancy[i][tic % BACKUPTICS];
+
+    return true;
+}
+
+//
+// G_RestoreTic
+//
+void G_RestoreTic (int tic)
+{
+    predictslot_t*	slot;
+    int			i;
+    int			j;
+
+    slot = &slots[tic % MAXPREDICTTICS];
+
+    if (slot->tic != tic)
+	I_Error ("G_RestoreTic: tic %i was not kept", tic);
+
+    // the sounds playing come from mobjs about to go
+    S_StopSounds ();
+
+    savegame_error = false;
+
+    P_OpenSaveBuffer (slot->data, slot->size);
+    P_UnArchiveSnapshot ();
+    P_CloseSaveBuffer ();
+
+    if (savegame_error)
+	I_Error ("G_RestoreTic: bad snapshot");
+
+    rndindex = slot->rndindex;
+
+    // a guessed tic may have ended the level
+    gameaction = ga_nothing;
+
+    // every tic run from this one on is to run again
+    for (i=0 ; i<MAXPREDICTTICS ; i++)
+    {
+	if (slots[i].tic < tic || slots[i].tic >= gametic)
+	    continue;
+
+	for (j=0 ; j<MAXPLAYERS ; j++)
+	{
+	    consistancy[j][slots[i].tic % BACKUPTICS]
+		= slots[i].consistancy[j];
+	}
+    }
+}
+
+//
+// G_PredictTiccmd
+// A player is guessed to go on as they last did, but without
+// the pauses, saves and chat that happen only once.  The guess
+// carries the consistancy check the game will make, so that
+// only a real command can fail it.
+//
+void G_PredictTiccmd (ticcmd_t *cmd, int player, int tic)
+{
+    if (cmd->buttons & BT_SPECIAL)
+	cmd->buttons = 0;
+
+    cmd->chatchar = 0;
+    cmd->consistancy = consistancy[player][tic % BACKUPTICS];
+}
@@ -0,0 +1,38 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Netgame prediction: the tics to come back to.
+//
+
+
+#ifndef __G_PREDICT__
+#define __G_PREDICT__
+
+#include "doomtype.h"
+#include "d_ticcmd.h"
+
+// Keeps the level as it is before the given tic.  Returns false
+// if it cannot be brought back, so no tic may run ahead of the
+// commands had for it.
+boolean G_SaveTic (int tic);
+
+// Puts the level back to how it was before the given tic, which
+// must be one of the last MAXPREDICTTICS kept.
+void G_RestoreTic (int tic);
+
+// Turns the last command had from a player into a guess at the
+// one for the given tic.
+void G_PredictTiccmd (ticcmd_t *cmd, int player, int tic);
+
+#endif
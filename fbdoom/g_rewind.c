@@ -0,0 +1,450 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Rewind buffer.  Every few tics the level is written out in
+//	the fast savegame format.  The newest snapshot is kept whole;
+//	each older one only as the bytes that differ from the one
+//	after it, which between snapshots a fraction of a second
+//	apart is little.  The rewind key steps back through them.
+//
+
+#include "stdio.h"
+#include "string.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "d_main.h"
+#include "g_rewind.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "p_saveg.h"
+#include "s_sound.h"
+#include "z_zone.h"
+
+// Most snapshots kept, besides the newest.
+
+#define MAXREWIND		128
+
+// Size the snapshot buffers start at.  They double whenever
+// a snapshot does not fit.
+
+#define REWIND_MINBUFFER	(64*1024)
+
+// Shortest run of unchanged bytes worth ending a literal for.
+
+#define REWIND_MINRUN		4
+
+// Snapshots taken between reports of their cost.
+
+#define REWIND_REPORT		16
+
+typedef struct
+{
+    byte*	data;
+    int		size;
+    int		leveltime;
+} rewind_t;
+
+int rewind_interval = 0;
+int rewind_memory = 1024;
+
+// The newest snapshot, whole, and room to write the next.
+
+static byte*		latest;
+static byte*		scratch;
+static byte*		deltabuffer;
+static int		buffersize;
+
+static int		latestsize;
+static int		latesttime = -1;
+
+// Older snapshots, oldest first, each as a delta against the
+// one after it.
+
+static rewind_t		rewinds[MAXREWIND];
+static int		rewindhead;
+static int		numrewinds;
+static int		rewindbytes;
+
+static uint64_t		snapshotcycles;
+static int		snapshotcount;
+
+//
+// G_SameBytes
+// Bytes alike in both, starting at pos, up to max.
+//
+int
+G_SameBytes
+( byte*		ref,
+  int		reflen,
+  byte*		target,
+  int		len,
+  int		pos,
+  int		max )
+{
+    int		count;
+
+    count = 0;
+
+    while (count < max
+	   && pos + count < len
+	   && pos + count < reflen
+	   && target[pos + count] == ref[pos + count])
+    {
+	count++;
+    }
+
+    return count;
+}
+
+//
+// G_EncodeDelta
+// Writes target as runs of bytes copied from ref and bytes
+// given literally.  Returns the size written to out, which is
+// at most twice len and a few bytes.
+//
+int
+G_EncodeDelta
+( byte*		ref,
+  int		reflen,
+  byte*		target,
+  int		len,
+  byte*		out )
+{
+    byte*		p;
+    unsigned short	same;
+    unsigned short	lit;
+    int			run;
+    int			i;
+
+    p = out;
+    memcpy (p, &len, sizeof(len));
+    p += sizeof(len);
+
+    i = 0;
+
+    while (i < len)
+    {
+	same = G_SameBytes (ref, reflen, target, len, i, 0xffff);
+	i += same;
+
+	// a short run of unchanged bytes costs more as a run
+	// than it saves, so it goes into the literal
+	lit = 0;
+
+	while (i + lit < len && lit < 0xffff)
+	{
+	    run = G_SameBytes (ref, reflen, target, len, i + lit,
+			       REWIND_MINRUN);
+
+	    if (run == 0)
+	    {
+		lit++;
+		continue;
+	    }
+
+	    if (run == REWIND_MINRUN
+		|| i + lit + run == len
+		|| lit + run > 0xffff)
+	    {
+		break;
+	    }
+
+	    lit += run;
+	}
+
+	memcpy (p, &same, sizeof(same));
+	p += sizeof(same);
+	memcpy (p, &lit, sizeof(lit));
+	p += sizeof(lit);
+	memcpy (p, target + i, lit);
+	p += lit;
+	i += lit;
+    }
+
+    return p - out;
+}
+
+//
+// G_DecodeDelta
+// Rebuilds into out what G_EncodeDelta wrote against ref.
+// Returns its size.
+//
+int G_DecodeDelta (byte* ref, byte* delta, byte* out)
+{
+    unsigned short	same;
+    unsigned short	lit;
+    int			len;
+    int			i;
+
+    memcpy (&len, delta, sizeof(len));
+    delta += sizeof(len);
+
+    i = 0;
+
+    while (i < len)
+    {
+	memcpy (&same, delta, sizeof(same));
+	delta += sizeof(same);
+	memcpy (&lit, delta, sizeof(lit));
+	delta += sizeof(lit);
+
+	memcpy (out + i, ref + i, same);
+	i += same;
+	memcpy (out + i, delta, lit);
+	delta += lit;
+	i += lit;
+    }
+
+    return len;
+}
+
+//
+// G_DropOldestRewind
+//
+static void G_DropOldestRewind (void)
+{
+    rewind_t*	r;
+
+    r = &rewinds[rewindhead];
+    rewindbytes -= r->size;
+    Z_Free (r->data);
+
+    rewindhead = (rewindhead + 1) % MAXREWIND;
+    numrewinds--;
+}
+
+//
+// G_ClearRewind
+//
+void G_ClearRewind (void)
+{
+    while (numrewinds > 0)
+	G_DropOldestRewind ();
+
+    rewindhead = 0;
+    latestsize = 0;
+    latesttime = -1;
+}
+
+//
+// G_GrowRewindBuffers
+// Doubles the snapshot buffers, keeping the newest snapshot.
+//
+static void G_GrowRewindBuffers (void)
+{
+    byte*	newlatest;
+
+    buffersize = buffersize ? buffersize * 2 : REWIND_MINBUFFER;
+
+    newlatest = Z_Malloc (buffersize, PU_STATIC, NULL);
+
+    if (latest != NULL)
+    {
+	memcpy (newlatest, latest, latestsize);
+	Z_Free (latest);
+	Z_Free (scratch);
+	Z_Free (deltabuffer);
+    }
+
+    latest = newlatest;
+    scratch = Z_Malloc (buffersize, PU_STATIC, NULL);
+    deltabuffer = Z_Malloc (buffersize * 2 + 16, PU_STATIC, NULL);
+}
+
+//
+// G_WriteSnapshot
+// Writes the level to scratch, and returns its size.
+//
+static int G_WriteSnapshot (void)
+{
+    int		size;
+
+    while (1)
+    {
+	if (buffersize == 0)
+	    G_GrowRewindBuffers ();
+
+	savegame_error = false;
+
+	P_OpenSaveBuffer (scratch, buffersize);
+	P_ArchiveSnapshot ();
+	size = P_SaveGamePosition ();
+	P_CloseSaveBuffer ();
+
+	if (!savegame_error)
+	    return size;
+
+	if (buffersize * 8 + 16 > rewind_memory * 1024)
+	    return -1;
+
+	G_GrowRewindBuffers ();
+    }
+}
+
+//
+// G_StoreRewind
+// Keeps the newest snapshot as a delta against the one just
+// written to scratch, dropping the oldest to stay in memory.
+//
+static void G_StoreRewind (int scratchsize)
+{
+    rewind_t*	r;
+    int		limit;
+    int		size;
+
+    size = G_EncodeDelta (scratch, scratchsize, latest, latestsize,
+			  deltabuffer);
+
+    // the buffers count against the limit too
+    limit = rewind_memory * 1024 - (buffersize * 4 + 16);
+
+    while (numrewinds > 0
+	   && (numrewinds == MAXREWIND || rewindbytes + size > limit))
+    {
+	G_DropOldestRewind ();
+    }
+
+    if (size > limit)
+	return;
+
+    r = &rewinds[(rewindhead + numrewinds) % MAXREWIND];
+    r->data = Z_Malloc (size, PU_STATIC, NULL);
+    r->size = size;
+    r->leveltime = latesttime;
+    memcpy (r->data, deltabuffer, size);
+
+    rewindbytes += size;
+    numrewinds++;
+}
+
+//
+// G_TakeSnapshot
+//
+static void G_TakeSnapshot (void)
+{
+    uint64_t	start;
+    byte*	swap;
+    int		size;
+
+    start = I_GetCycles ();
+
+    size = G_WriteSnapshot ();
+
+    if (size < 0)
+    {
+	printf ("G_TakeSnapshot: level does not fit in %i KiB\n",
+		rewind_memory);
+	G_ClearRewind ();
+	rewind_interval = 0;
+	return;
+    }
+
+    if (latesttime >= 0)
+	G_StoreRewind (size);
+
+    swap = latest;
+    latest = scratch;
+    scratch = swap;
+    latestsize = size;
+    latesttime = leveltime;
+
+    snapshotcycles += I_GetCycles () - start;
+    snapshotcount++;
+
+    if (snapshotcount == REWIND_REPORT)
+    {
+	printf ("G_Rewind: %i bytes, %i kept in %i bytes, "
+		"%llu cycles per tic\n",
+		latestsize, numrewinds, rewindbytes,
+		(unsigned long long) (snapshotcycles
+				      / (REWIND_REPORT * rewind_interval)));
+	snapshotcycles = 0;
+	snapshotcount = 0;
+    }
+}
+
+//
+// G_RewindAvailable
+//
+boolean G_RewindAvailable (void)
+{
+    return rewind_interval > 0
+	&& gamestate == GS_LEVEL
+	&& latesttime >= 0
+	&& !netgame
+	&& !demoplayback
+	&& !demorecording;
+}
+
+//
+// G_RewindTicker
+//
+void G_RewindTicker (void)
+{
+    if (rewind_interval <= 0 || netgame || demoplayback || demorecording)
+	return;
+
+    // leveltime stands still while the game is paused
+    if (latesttime >= 0 && leveltime - latesttime < rewind_interval)
+	return;
+
+    G_TakeSnapshot ();
+}
+
+//
+// G_DoRewind
+// Goes back to the newest snapshot, or, if that was taken only
+// a moment ago, to the one before it, so that pressing the key
+// again keeps stepping back.
+//
+void G_DoRewind (void)
+{
+    rewind_t*	r;
+    byte*	swap;
+
+    gameaction = ga_nothing;
+
+    if (!G_RewindAvailable ())
+	return;
+
+    if (leveltime - latesttime < TICRATE && numrewinds > 0)
+    {
+	r = &rewinds[(rewindhead + numrewinds - 1) % MAXREWIND];
+
+	latestsize = G_DecodeDelta (latest, r->data, scratch);
+	latesttime = r->leveltime;
+
+	swap = latest;
+	latest = scratch;
+	scratch = swap;
+
+	rewindbytes -= r->size;
+	Z_Free (r->data);
+	numrewinds--;
+    }
+
+    // the sounds playing come from mobjs about to go
+    S_StopSounds ();
+
+    savegame_error = false;
+
+    P_OpenSaveBuffer (latest, latestsize);
+    P_UnArchiveSnapshot ();
+    P_CloseSaveBuffer ();
+
+    if (savegame_error)
+	I_Error ("G_DoRewind: bad snapshot");
+}
@@ -0,0 +1,47 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Rewind buffer.
+//
+
+
+#ifndef __G_REWIND__
+#define __G_REWIND__
+
+#include "doomtype.h"
+
+// Tics between snapshots, or 0 to keep none.
+extern int rewind_interval;
+
+// Kilobytes the snapshots may use in all.
+extern int rewind_memory;
+
+// Forgets every snapshot, when a level is loaded.
+void G_ClearRewind (void);
+
+// True if there is a snapshot to go back to.
+boolean G_RewindAvailable (void);
+
+// Called after every level tic, to take the snapshots.
+void G_RewindTicker (void);
+
+// Puts the level back to the last snapshot.
+void G_DoRewind (void);
+
+// Snapshot deltas: target as the runs that differ from ref,
+// and back again.  Both return the size written to out.
+int G_EncodeDelta (byte* ref, int reflen, byte* target, int len, byte* out);
+int G_DecodeDelta (byte* ref, byte* delta, byte* out);
+
+#endif
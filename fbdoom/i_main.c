@@ -48,12 +48,17 @@ void print_hex(size_t a) {
 }
 
 int printf(const char *format, ...) {
+	char buf[512];
+	va_list ap;
 	int i = 0;
-	while (format[i] != 0x00) {
-		UART[0] = format[i];
+	va_start(ap, format);
+	vsnprintf(buf, sizeof(buf), format, ap);
+	va_end(ap);
+	while (buf[i] != 0x00) {
+		UART[0] = buf[i];
 		i++;
 	}
-	return 0;
+	return i;
 }
 
 /** add padding to string */
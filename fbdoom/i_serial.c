@@ -0,0 +1,299 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Serial ports.  The UART is a 16550 on the memory bus, and
+//	has no interrupt hooked up, so it is polled into a pair of
+//	queues like the ones the DOS serial driver filled from its
+//	interrupt handler.  The pipe is two such queues crossed
+//	over, with each byte held back for a set delay, and some
+//	writes thrown away.
+//
+
+#include "stdio.h"
+
+#include "i_serial.h"
+#include "i_timer.h"
+#include "z_zone.h"
+
+// Where the UART is, set with -DSERIAL_UART_BASE.  It must be a
+// second UART: printf writes the console one without looking at
+// its status, which would break up packets, and serial_baud would
+// set the console's rate.  With none, there is no serial game.
+
+#define CONSOLE_UART_BASE	0x10000000
+
+#ifndef SERIAL_UART_BASE
+#define SERIAL_UART_BASE	0
+#endif
+
+#if SERIAL_UART_BASE == CONSOLE_UART_BASE
+#error "SERIAL_UART_BASE must not be the console UART"
+#endif
+
+// Clock the UART divides down to make its baud rate.
+
+#ifndef SERIAL_UART_CLOCK
+#define SERIAL_UART_CLOCK	1843200
+#endif
+
+#define SERIAL_UART	((volatile byte *) SERIAL_UART_BASE)
+
+#define TRANSMIT_HOLDING_REGISTER	0x00
+#define RECEIVE_BUFFER_REGISTER		0x00
+#define INTERRUPT_ENABLE_REGISTER	0x01
+#define FIFO_CONTROL_REGISTER		0x02
+#define   FCR_FIFO_ENABLE		0x01
+#define   FCR_RCVR_FIFO_RESET		0x02
+#define   FCR_XMIT_FIFO_RESET		0x04
+#define   FCR_TRIGGER_14		0xc0
+#define LINE_CONTROL_REGISTER		0x03
+#define   LCR_DLAB			0x80
+#define LINE_STATUS_REGISTER		0x05
+#define   LSR_DATA_READY		0x01
+#define   LSR_THRE			0x20
+#define DIVISOR_LATCH_LOW		0x00
+#define DIVISOR_LATCH_HIGH		0x01
+
+// Bytes the transmit FIFO takes once it is empty.
+
+#define SERIAL_FIFO	16
+
+#define QUESIZE		2048
+
+typedef struct
+{
+    int		head, tail;	// bytes are put on head and pulled from tail
+    byte	data[QUESIZE];
+    int		time[QUESIZE];	// when each byte arrives, for a pipe
+} que_t;
+
+struct serialport_s
+{
+    que_t		inque;
+    que_t		outque;
+
+    // The other end, for a pipe.
+
+    serialport_t*	pipe;
+    int			delay;
+    int			lossrate;
+    int			(*clock) (void);
+};
+
+static serialport_t*	uartport;
+
+// Picks the pipe writes to lose.  Kept apart from the game's
+// random numbers so a lossy pipe cannot change the game.
+
+static unsigned int	lossseed;
+
+//
+// I_NewSerialPort
+//
+static serialport_t *I_NewSerialPort (void)
+{
+    serialport_t*	port;
+
+    port = Z_Malloc (sizeof(*port), PU_STATIC, NULL);
+    port->inque.head = port->inque.tail = 0;
+    port->outque.head = port->outque.tail = 0;
+    port->pipe = NULL;
+    port->delay = 0;
+    port->lossrate = 0;
+    port->clock = I_GetClockMS;
+
+    return port;
+}
+
+//
+// I_OpenSerialPort
+//
+serialport_t *I_OpenSerialPort (int baud)
+{
+    int		divisor;
+    int		i;
+
+    if (SERIAL_UART_BASE == 0)
+	return NULL;
+
+    if (uartport)
+	return uartport;
+
+    uartport = I_NewSerialPort ();
+
+    // polled: no interrupts
+    SERIAL_UART[INTERRUPT_ENABLE_REGISTER] = 0;
+
+    if (baud > 0)
+    {
+	divisor = SERIAL_UART_CLOCK / (16 * baud);
+
+	// N81
+	SERIAL_UART[LINE_CONTROL_REGISTER] = LCR_DLAB | 0x03;
+	SERIAL_UART[DIVISOR_LATCH_LOW] = divisor & 0xff;
+	SERIAL_UART[DIVISOR_LATCH_HIGH] = divisor >> 8;
+	SERIAL_UART[LINE_CONTROL_REGISTER] = 0x03;
+
+	printf ("I_OpenSerialPort: %i baud\n", SERIAL_UART_CLOCK / (16 * divisor));
+    }
+
+    SERIAL_UART[FIFO_CONTROL_REGISTER] = FCR_FIFO_ENABLE
+				       | FCR_RCVR_FIFO_RESET
+				       | FCR_XMIT_FIFO_RESET
+				       | FCR_TRIGGER_14;
+
+    // clear an entire 16550 silo
+    for (i=0 ; i<16 ; i++)
+	(void) SERIAL_UART[RECEIVE_BUFFER_REGISTER];
+
+    return uartport;
+}
+
+//
+// I_OpenSerialPipe
+//
+void I_OpenSerialPipe (serialport_t **a, serialport_t **b, int delayms,
+		       int lossrate, int (*clock) (void))
+{
+    *a = I_NewSerialPort ();
+    *b = I_NewSerialPort ();
+
+    (*a)->pipe = *b;
+    (*b)->pipe = *a;
+    (*a)->delay = (*b)->delay = delayms;
+    (*a)->lossrate = (*b)->lossrate = lossrate;
+    (*a)->clock = (*b)->clock = clock;
+
+    lossseed = 1;
+}
+
+//
+// I_CloseSerialPort
+//
+void I_CloseSerialPort (serialport_t *port)
+{
+    // the UART stays open
+    if (port != uartport)
+	Z_Free (port);
+}
+
+//
+// I_PollSerialPort
+//
+void I_PollSerialPort (serialport_t *port)
+{
+    que_t*	que;
+    int		count;
+
+    if (port->pipe)
+	return;
+
+    que = &port->inque;
+
+    while (SERIAL_UART[LINE_STATUS_REGISTER] & LSR_DATA_READY)
+    {
+	que->data[que->head & (QUESIZE-1)] = SERIAL_UART[RECEIVE_BUFFER_REGISTER];
+	que->head++;
+
+	// on overflow the oldest bytes are lost, and the reader
+	// throws out the packet they were in
+	if (que->head - que->tail > QUESIZE)
+	    que->tail = que->head - QUESIZE;
+    }
+
+    que = &port->outque;
+
+    if (SERIAL_UART[LINE_STATUS_REGISTER] & LSR_THRE)
+    {
+	for (count = 0 ; count < SERIAL_FIFO && que->tail < que->head ; count++)
+	{
+	    SERIAL_UART[TRANSMIT_HOLDING_REGISTER]
+		= que->data[que->tail & (QUESIZE-1)];
+	    que->tail++;
+	}
+    }
+}
+
+//
+// I_SerialReadByte
+//
+int I_SerialReadByte (serialport_t *port)
+{
+    que_t*	que;
+    int		c;
+
+    que = &port->inque;
+
+    if (que->tail >= que->head)
+	return -1;
+
+    if (port->pipe && que->time[que->tail & (QUESIZE-1)] - port->clock () > 0)
+	return -1;
+
+    c = que->data[que->tail & (QUESIZE-1)];
+    que->tail++;
+
+    return c;
+}
+
+//
+// I_SerialWrite
+//
+void I_SerialWrite (serialport_t *port, byte *data, int length)
+{
+    que_t*	que;
+    int		time;
+
+    if (port->pipe)
+    {
+	lossseed = lossseed * 1103515245 + 12345;
+
+	if ((lossseed >> 16) % 100 < port->lossrate)
+	    return;
+
+	que = &port->pipe->inque;
+    }
+    else
+    {
+	que = &port->outque;
+    }
+
+    // if this would overrun the buffer, throw everything else out
+    if (que->head - que->tail + length > QUESIZE)
+	que->tail = que->head;
+
+    time = port->clock () + port->delay;
+
+    while (length--)
+    {
+	que->data[que->head & (QUESIZE-1)] = *data++;
+	que->time[que->head & (QUESIZE-1)] = time;
+	que->head++;
+    }
+
+    I_PollSerialPort (port);
+}
+
+//
+// I_SerialSent
+//
+boolean I_SerialSent (serialport_t *port)
+{
+    if (port->pipe)
+	return true;
+
+    return port->outque.tail >= port->outque.head
+	&& (SERIAL_UART[LINE_STATUS_REGISTER] & LSR_THRE) != 0;
+}
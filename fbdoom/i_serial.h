@@ -0,0 +1,65 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Serial ports: the MMIO UART, and an in-memory pipe that
+//	stands in for a cable between two ends in one process, and
+//	can be made slow and lossy.
+//
+
+
+#ifndef __I_SERIAL__
+#define __I_SERIAL__
+
+#include "doomtype.h"
+
+typedef struct serialport_s serialport_t;
+
+// Opens the UART, setting the baud rate unless it is 0.  Returns
+// NULL if the build has no UART for a serial game.
+
+serialport_t *I_OpenSerialPort (int baud);
+
+// Opens both ends of a pipe.  Bytes written to one end can be
+// read from the other delayms milliseconds later, as told by
+// clock, except that lossrate percent of the writes are lost.
+
+void I_OpenSerialPipe (serialport_t **a, serialport_t **b, int delayms,
+		       int lossrate, int (*clock) (void));
+
+// Frees one end of a pipe.  Close both ends together.
+
+void I_CloseSerialPort (serialport_t *port);
+
+// Moves bytes between the UART and the queues.  The UART is
+// polled, so this must be called more often than its receive
+// FIFO fills.
+
+void I_PollSerialPort (serialport_t *port);
+
+// Returns the next byte received, or -1 if there is none.
+
+int I_SerialReadByte (serialport_t *port);
+
+// Queues bytes to send.  If they would overrun the queue,
+// everything queued before them is thrown out.
+
+void I_SerialWrite (serialport_t *port, byte *data, int length);
+
+// Returns true once everything queued has been sent.
+
+boolean I_SerialSent (serialport_t *port);
+
+#endif
+
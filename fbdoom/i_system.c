@@ -55,8 +55,43 @@
 #include <CoreFoundation/CFUserNotification.h>
 #endif
 
+// Boards with only a few MiB can build with a smaller zone, eg.
+// -DDEFAULT_RAM=3.  The zone then purges caches and rebuilds them
+// on demand (see Z_AtLowMemory) rather than failing outright.
+
+#ifndef DEFAULT_RAM
 #define DEFAULT_RAM 6 /* MiB */
-#define MIN_RAM     6  /* MiB */
+#endif
+
+#ifndef MIN_RAM
+#define MIN_RAM     DEFAULT_RAM  /* MiB */
+#endif
+
+// Reserved memory windows.  These lie above the mapped WAD and
+// outside the zone, and the loader leaves them alone across a warm
+// reset, so anything kept there survives a reboot of the board.
+
+#define DATAINDEX_BASE ((byte *) 0x80c00000)
+#define DATAINDEX_SIZE (1024 * 1024)
+
+// Savegame slots.  On boards that back this range with battery
+// RAM or NVRAM, saves also survive a power cycle.  Set the size
+// to 0 to fall back to savegame files.
+
+#ifndef SAVEGAME_SIZE
+#define SAVEGAME_SIZE (2 * 1024 * 1024)
+#endif
+
+#define SAVEGAME_BASE ((byte *) 0x80d00000)
+
+// Demo being recorded, for when there is no file to write it
+// to.  Set the size to 0 if there is no such window.
+
+#ifndef DEMOWINDOW_SIZE
+#define DEMOWINDOW_SIZE (1024 * 1024)
+#endif
+
+#define DEMOWINDOW_BASE ((byte *) 0x80f00000)
 
 
 typedef struct atexit_listentry_s atexit_listentry_t;
@@ -139,10 +174,10 @@ byte *I_ZoneBase (int *size)
     //!
     // @arg <mb>
     //
-    // Specify the heap size, in MiB (default 16).
+    // Specify the heap size, in MiB (default 6).
     //
 	printf("zonebase args\n");
-    p = 0;//M_CheckParmWithArgs("-mb", 1);
+    p = M_CheckParmWithArgs("-mb", 1);
 	printf("zonebase if\n");
     if (p > 0)
     {
@@ -164,6 +199,27 @@ byte *I_ZoneBase (int *size)
     return zonemem;
 }
 
+byte *I_DataIndexBase (int *size)
+{
+    *size = DATAINDEX_SIZE;
+
+    return DATAINDEX_BASE;
+}
+
+byte *I_SaveGameBase (int *size)
+{
+    *size = SAVEGAME_SIZE;
+
+    return SAVEGAME_BASE;
+}
+
+byte *I_DemoWindowBase (int *size)
+{
+    *size = DEMOWINDOW_SIZE;
+
+    return DEMOWINDOW_BASE;
+}
+
 void I_PrintBanner(char *msg)
 {
     //int i;
@@ -34,6 +34,19 @@ void I_Init (void);
 // for the zone management.
 byte*	I_ZoneBase (int *size);
 
+// Reserved memory window, outside the zone,
+// that keeps the renderer's data index
+// across a warm reset.
+byte*	I_DataIndexBase (int *size);
+
+// Reserved memory window for the savegame slots.
+// Size 0 if there is none.
+byte*	I_SaveGameBase (int *size);
+
+// Reserved memory window for the demo being
+// recorded.  Size 0 if there is none.
+byte*	I_DemoWindowBase (int *size);
+
 boolean I_ConsoleStdout(void);
 
 
@@ -76,6 +76,32 @@ int I_GetTimeMS(void)
     return ticks - basetime;
 }
 
+//
+// I_GetCycles
+// Returns the free running CPU cycle counter, for profiling.
+//
+
+uint64_t I_GetCycles(void)
+{
+    uint64_t cycles;
+
+    __asm__ volatile ("rdcycle %0" : "=r"(cycles));
+
+    return cycles;
+}
+
+//
+// I_GetClockMS
+// I_GetTimeMS counts calls on this board, so anything that must
+// wait on the wall clock counts cycles instead.  Wraps after
+// about 49 days, which differences of two readings ride over.
+//
+
+int I_GetClockMS(void)
+{
+    return (int) (uint32_t) (I_GetCycles() / ((uint64_t) CLOCK_MHZ * 1000));
+}
+
 // Sleep for a specified number of ms
 
 void I_Sleep(int ms)
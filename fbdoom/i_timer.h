@@ -20,8 +20,17 @@
 #ifndef __I_TIMER__
 #define __I_TIMER__
 
+#include "doomtype.h"
+
 #define TICRATE 35
 
+// Core clock of the board, which I_GetCycles counts.  Set it
+// to match with -DCLOCK_MHZ=n.
+
+#ifndef CLOCK_MHZ
+#define CLOCK_MHZ 100
+#endif
+
 // Called by D_DoomLoop,
 // returns current time in tics.
 int I_GetTime (void);
@@ -29,6 +38,13 @@ int I_GetTime (void);
 // returns current time in ms
 int I_GetTimeMS (void);
 
+// returns the CPU cycle counter, for profiling
+uint64_t I_GetCycles (void);
+
+// returns ms counted off the cycle counter at CLOCK_MHZ, for
+// timeouts that must follow the wall clock
+int I_GetClockMS (void);
+
 // Pause for a specified number of ms
 void I_Sleep(int ms);
 
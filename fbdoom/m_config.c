@@ -827,6 +827,165 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(show_endoom),
 
+    //!
+    // @game doom
+    //
+    // If non-zero, frames are drawn as fast as the display allows
+    // rather than once per tic, and moving things, sectors and the
+    // view are interpolated between tics.  The play simulation
+    // still runs at 35 tics per second.
+    //
+
+    CONFIG_VARIABLE_INT(uncapped_framerate),
+
+    //!
+    // @game doom
+    //
+    // Frame rate the load governor tries to hold.  When the tics
+    // and the view refresh take longer than that allows, it drops
+    // to low detail, then shrinks the view, then skips drawing
+    // frames.  Zero, the default, turns the governor off.  It
+    // times them against a core clock of CLOCK_MHZ, which must
+    // be built to match the board.
+    //
+
+    CONFIG_VARIABLE_INT(govern_target_fps),
+
+    //!
+    // @game doom
+    //
+    // How far under its budget, in percent, the load has to fall
+    // before the load governor gives detail back.
+    //
+
+    CONFIG_VARIABLE_INT(govern_hysteresis),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, games are saved in the fast format, which only
+    // this port can load.  If zero, they are saved in the Vanilla
+    // format.  Either format can be loaded.
+    //
+
+    CONFIG_VARIABLE_INT(fast_savegames),
+
+    //!
+    // @game doom
+    //
+    // Tics between the snapshots of the level kept for rewinding.
+    // Zero turns the rewind buffer off.
+    //
+
+    CONFIG_VARIABLE_INT(rewind_interval),
+
+    //!
+    // @game doom
+    //
+    // Memory for the rewind buffer, in kilobytes.  The oldest
+    // snapshots are dropped to stay within it.
+    //
+
+    CONFIG_VARIABLE_INT(rewind_memory),
+
+    //!
+    // @game doom
+    //
+    // Tics between the keyframes kept of a demo played with
+    // -playdemo, which make it possible to seek in it.  Zero
+    // plays demos as Vanilla does.
+    //
+
+    CONFIG_VARIABLE_INT(demo_keyframe_interval),
+
+    //!
+    // @game doom
+    //
+    // Memory for the keyframes of a demo, in kilobytes.
+    //
+
+    CONFIG_VARIABLE_INT(demo_keyframe_memory),
+
+    //!
+    // @game doom
+    //
+    // Where a demo being recorded goes as it is recorded: 0 keeps
+    // it to write to a file at the end, 1 sends it down the
+    // console as hex lines, 2 copies it into the reserved demo
+    // memory window.
+    //
+
+    CONFIG_VARIABLE_INT(demo_stream),
+
+    //!
+    // @game doom
+    //
+    // Two player game across a serial link: 0 plays alone, 1 plays
+    // against another board on the UART built in with
+    // -DSERIAL_UART_BASE, which must not be the console's, 2 plays
+    // against a stand-in player down an in-memory pipe, for
+    // testing.  Both boards must be set up for the same episode,
+    // map and skill.
+    //
+
+    CONFIG_VARIABLE_INT(serial_link),
+
+    //!
+    // @game doom
+    //
+    // Baud rate to set the UART to for a serial game, or 0 to
+    // leave it as the firmware set it.
+    //
+
+    CONFIG_VARIABLE_INT(serial_baud),
+
+    //!
+    // @game doom
+    //
+    // Player to be in a serial game: 1 or 2, or 0 to let the two
+    // ends decide between them.
+    //
+
+    CONFIG_VARIABLE_INT(serial_player),
+
+    //!
+    // @game doom
+    //
+    // Milliseconds each byte takes to get through the loopback
+    // pipe, one way, and through the serial link the headless
+    // simulation tries.
+    //
+
+    CONFIG_VARIABLE_INT(serial_latency),
+
+    //!
+    // @game doom
+    //
+    // Percent of packets lost in the loopback pipe, and in the
+    // serial link the headless simulation tries.
+    //
+
+    CONFIG_VARIABLE_INT(serial_loss),
+
+    //!
+    // @game doom
+    //
+    // Tics sent again with every new one across the serial link,
+    // so that a lost packet needs no resend.
+    //
+
+    CONFIG_VARIABLE_INT(serial_extratics),
+
+    //!
+    // @game doom
+    //
+    // Tics a netgame may run ahead of the other player, guessing
+    // that they go on as they last did, and running the tics
+    // again if not.  Up to 16; 0 waits for them as Vanilla does.
+    //
+
+    CONFIG_VARIABLE_INT(predict_tics),
+
     //!
     // If non-zero, save screenshots in PNG format.
     //
@@ -1488,6 +1647,38 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_KEY(key_demo_quit),
 
+    //!
+    // Key to step back to the last rewind snapshot.
+    //
+
+    CONFIG_VARIABLE_KEY(key_rewind),
+
+    //!
+    // Key to go back ten seconds in a demo being reviewed.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demo_back),
+
+    //!
+    // Key to go ahead ten seconds in a demo being reviewed.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demo_ahead),
+
+    //!
+    // Key to double the speed a demo being reviewed plays at,
+    // back to normal after 16 times.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demo_speed),
+
+    //!
+    // Key to hold a demo being reviewed, then step it one tic
+    // at a time.
+    //
+
+    CONFIG_VARIABLE_KEY(key_demo_step),
+
     //!
     // Key to send a message during multiplayer games.
     //
@@ -111,6 +111,14 @@ int key_message_refresh = KEY_ENTER;
 int key_pause = KEY_PAUSE;
 int key_demo_quit = 'q';
 int key_spy = KEY_F12;
+int key_rewind = KEY_BACKSPACE;
+
+// Demo review keys:
+
+int key_demo_back = KEY_LEFTARROW;
+int key_demo_ahead = KEY_RIGHTARROW;
+int key_demo_speed = KEY_UPARROW;
+int key_demo_step = KEY_DOWNARROW;
 
 // Multiplayer chat keys:
 
@@ -370,6 +378,11 @@ void M_BindMenuControls(void)
     M_BindVariable("key_menu_screenshot",&key_menu_screenshot);
     M_BindVariable("key_demo_quit",      &key_demo_quit);
     M_BindVariable("key_spy",            &key_spy);
+    M_BindVariable("key_rewind",         &key_rewind);
+    M_BindVariable("key_demo_back",      &key_demo_back);
+    M_BindVariable("key_demo_ahead",     &key_demo_ahead);
+    M_BindVariable("key_demo_speed",     &key_demo_speed);
+    M_BindVariable("key_demo_step",      &key_demo_step);
 }
 
 void M_BindChatControls(unsigned int num_players)
@@ -54,6 +54,12 @@ extern int key_invdrop;
 
 extern int key_message_refresh;
 extern int key_pause;
+extern int key_rewind;
+
+extern int key_demo_back;
+extern int key_demo_ahead;
+extern int key_demo_speed;
+extern int key_demo_step;
 
 extern int key_multi_msg;
 extern int key_multi_msgplayer[8];
@@ -508,6 +508,20 @@ void M_ReadSaveStrings(void)
 
     for (i = 0;i < load_end;i++)
     {
+        if (P_SaveSlotsAvailable())
+        {
+            if (P_ReadSaveSlotDescription(i, savegamestrings[i]))
+            {
+                LoadMenu[i].status = 1;
+            }
+            else
+            {
+                M_StringCopy(savegamestrings[i], EMPTYSTRING, SAVESTRINGSIZE);
+                LoadMenu[i].status = 0;
+            }
+            continue;
+        }
+
         M_StringCopy(name, P_SaveGameFile(i), sizeof(name));
 
 	handle = fopen(name, "rb");
@@ -571,11 +585,7 @@ void M_DrawSaveLoadBorder(int x,int y)
 //
 void M_LoadSelect(int choice)
 {
-    char    name[256];
-	
-    M_StringCopy(name, P_SaveGameFile(choice), sizeof(name));
-
-    G_LoadGame (name);
+    G_LoadGameSlot (choice);
     M_ClearMenus ();
 }
 
@@ -513,6 +513,42 @@ int M_snprintf(char *buf, size_t buf_len, const char *s, ...)
     return result;
 }
 
+// CRC-32 of a block, for data kept in memory across boots.
+unsigned int M_CRC32(const byte *data, int length)
+{
+    static unsigned int crctable[256];
+    static boolean crcready;
+    unsigned int crc;
+    int i;
+    int j;
+
+    if (!crcready)
+    {
+        for (i=0; i<256; ++i)
+        {
+            crc = i;
+
+            for (j=0; j<8; ++j)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+            }
+
+            crctable[i] = crc;
+        }
+
+        crcready = true;
+    }
+
+    crc = 0xffffffff;
+
+    for (i=0; i<length; ++i)
+    {
+        crc = crctable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xffffffff;
+}
+
 #ifdef _WIN32
 
 char *M_OEMToUTF8(const char *oem)
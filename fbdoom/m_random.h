@@ -35,5 +35,11 @@ int P_Random (void);
 // Fix randoms for demos.
 void M_ClearRandom (void);
 
+// Index of the next M_Random value.
+extern int rndindex;
+
+// Index of the next P_Random value.
+extern int prndindex;
+
 
 #endif
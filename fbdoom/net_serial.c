@@ -0,0 +1,1069 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Two player netgame over a serial line, after the DOS serial
+//	driver.  Packets are framed and escaped the same way, and
+//	the two ends trade ids to work out who is player 0.  Each
+//	end then sends its ticcmds, each coded against the tic
+//	before it, together with the number of tics it has had
+//	from the other end.  The last few tics ride along with
+//	every new one, so a lost packet costs no round trip; any
+//	the other end still has not had are sent again later.
+//
+
+#include "stdio.h"
+#include "string.h"
+
+#include "doomdef.h"
+
+#include "d_loop.h"
+#include "i_serial.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
+#include "net_client.h"
+#include "net_serial.h"
+#include "z_zone.h"
+
+#define MAXPACKET	512
+
+// A packet is sent as FRAMECHAR FRAMESTART, the packet with any
+// FRAMECHAR doubled, then FRAMECHAR FRAMEEND.  The start marker
+// lets the reader skip line noise and the rest of a broken packet.
+
+#define FRAMECHAR	0x70
+#define FRAMESTART	0x01
+#define FRAMEEND	0x00
+
+// Most bytes of a ticcmd on the line: the NET_TICDIFF_* flags,
+// a byte for each of five fields, and up to three for the turn.
+
+#define MAXTICCMDSIZE	9
+
+// Most tics sent in one packet.
+
+#define SERIAL_MAXTICS	8
+
+// Tics the other end has not had are sent again this often.
+
+#define SERIAL_RESENDMS		100
+
+// Hellos go out this often while connecting.
+
+#define SERIAL_HELLOMS		1000
+
+#define SERIAL_CONNECTMS	(60 * 1000)
+#define SERIAL_TIMEOUTMS	(30 * 1000)
+
+typedef enum
+{
+    pkt_hello,		// id string and acknowledge stage
+    pkt_tics,		// acknowledge, start tic, ticcmds
+    pkt_quit,
+} serialpacket_t;
+
+typedef struct
+{
+    serialport_t*	port;
+
+    // The packet being read.
+
+    byte		packet[MAXPACKET];
+    int			packetlen;
+    boolean		inframe;
+    boolean		inescape;
+
+    // The acknowledge stage starts out 0, is bumped to 1 after
+    // the other end's id is known, and is bumped to 2 after the
+    // other end has raised to 1.
+
+    char		idstr[7];
+    char		remoteidstr[7];
+    int			stage;
+    int			lasthello;
+    int			player;
+
+    // Tics made at this end, kept until the other end has them.
+
+    ticcmd_t		sendcmds[BACKUPTICS];
+    int			maketic;
+    int			sendtic;
+    int			remoteack;
+    int			lastack;
+    int			lastsend;
+    int			lastresend;
+    int			bytessent;
+
+    // Tics had from the other end, kept to code the next ones
+    // against.
+
+    ticcmd_t		recvcmds[BACKUPTICS];
+    int			recvtic;
+    int			ackedtic;
+    int			lastrecv;
+
+    boolean		quit;
+} serialnode_t;
+
+int serial_link = seriallink_none;
+int serial_baud = 0;
+int serial_player = 0;
+int serial_latency = 50;
+int serial_loss = 0;
+int serial_extratics = 2;
+
+extern byte consistancy[MAXPLAYERS][BACKUPTICS];
+
+static serialnode_t	localnode;
+
+// The stand-in player at the other end of the loopback pipe,
+// and the consistancy checks the game had for it as each tic
+// was made here, before the game could run ahead of them.
+
+static serialnode_t	loopnode;
+static byte		loopchecks[BACKUPTICS];
+
+static boolean		connected;
+static boolean		loopback;
+
+// While simulating a link, the clock is simulated too.  The
+// tics coming out of NET_SerialSimulate are checked against the
+// ones that went in; the stand-in plays them.
+
+static boolean		simulating;
+static int		simtime;
+static ticcmd_t*	simcmds;
+static int		simnumtics;
+
+//
+// NET_SerialTime
+//
+static int NET_SerialTime (void)
+{
+    if (simulating)
+	return simtime;
+
+    return I_GetClockMS ();
+}
+
+//
+// NET_SerialChecksum
+//
+static unsigned int NET_SerialChecksum (byte *data, int length)
+{
+    unsigned int	sum1;
+    unsigned int	sum2;
+
+    sum1 = sum2 = 0;
+
+    while (length--)
+    {
+	sum1 = (sum1 + *data++) % 255;
+	sum2 = (sum2 + sum1) % 255;
+    }
+
+    return (sum2 << 8) | sum1;
+}
+
+//
+// NET_SerialWritePacket
+//
+static void NET_SerialWritePacket (serialnode_t *node, byte *data, int len)
+{
+    static byte		localbuffer[MAXPACKET*2+8];
+    unsigned int	sum;
+    int			b;
+    int			i;
+    byte		c;
+
+    if (len > MAXPACKET - 2)
+	return;
+
+    sum = NET_SerialChecksum (data, len);
+
+    b = 0;
+    localbuffer[b++] = FRAMECHAR;
+    localbuffer[b++] = FRAMESTART;
+
+    for (i=0 ; i<len+2 ; i++)
+    {
+	if (i < len)
+	    c = data[i];
+	else if (i == len)
+	    c = sum & 0xff;
+	else
+	    c = sum >> 8;
+
+	if (c == FRAMECHAR)
+	    localbuffer[b++] = FRAMECHAR;	// escape it for literal
+	localbuffer[b++] = c;
+    }
+
+    localbuffer[b++] = FRAMECHAR;
+    localbuffer[b++] = FRAMEEND;
+
+    I_SerialWrite (node->port, localbuffer, b);
+    node->bytessent += b;
+}
+
+//
+// NET_SerialReadPacket
+// Returns true with a good packet in node->packet.
+//
+static boolean NET_SerialReadPacket (serialnode_t *node)
+{
+    int		c;
+    int		len;
+
+    while ((c = I_SerialReadByte (node->port)) >= 0)
+    {
+	if (node->inescape)
+	{
+	    node->inescape = false;
+
+	    if (c == FRAMESTART)
+	    {
+		node->inframe = true;
+		node->packetlen = 0;
+		continue;
+	    }
+
+	    if (c == FRAMEEND && node->inframe)
+	    {
+		node->inframe = false;
+		len = node->packetlen - 2;
+
+		if (len > 0
+		 && NET_SerialChecksum (node->packet, len)
+		    == (node->packet[len] | (node->packet[len+1] << 8)))
+		{
+		    node->packetlen = len;
+		    return true;		// got a good packet
+		}
+
+		continue;
+	    }
+
+	    if (c != FRAMECHAR)
+	    {
+		node->inframe = false;
+		continue;
+	    }
+	}
+	else if (c == FRAMECHAR)
+	{
+	    node->inescape = true;
+	    continue;			// don't know yet if it is a marker
+	}				// or a literal FRAMECHAR
+
+	if (!node->inframe)
+	    continue;
+
+	if (node->packetlen >= MAXPACKET)
+	{
+	    node->inframe = false;	// oversize packet
+	    continue;
+	}
+
+	node->packet[node->packetlen++] = c;
+    }
+
+    return false;
+}
+
+//
+// NET_SerialWriteTiccmd
+// A ticcmd goes out as a byte of NET_TICDIFF_* flags for the
+// fields that differ from the tic before, then those fields.
+// The turn goes as its change from the tic before, zigzagged
+// so small turns either way take a byte, seven bits at a time.
+// A tic just like the one before is the flags byte alone.
+//
+static byte *NET_SerialWriteTiccmd (byte *p, ticcmd_t *cmd, ticcmd_t *prev)
+{
+    byte*		flags;
+    unsigned int	turn;
+    short		delta;
+
+    flags = p++;
+    *flags = 0;
+
+    if (cmd->forwardmove != prev->forwardmove)
+    {
+	*flags |= NET_TICDIFF_FORWARD;
+	*p++ = cmd->forwardmove;
+    }
+
+    if (cmd->sidemove != prev->sidemove)
+    {
+	*flags |= NET_TICDIFF_SIDE;
+	*p++ = cmd->sidemove;
+    }
+
+    if (cmd->angleturn != prev->angleturn)
+    {
+	*flags |= NET_TICDIFF_TURN;
+
+	delta = (short) (cmd->angleturn - prev->angleturn);
+	turn = delta < 0 ? ((-delta) << 1) - 1 : delta << 1;
+
+	while (turn >= 0x80)
+	{
+	    *p++ = (turn & 0x7f) | 0x80;
+	    turn >>= 7;
+	}
+
+	*p++ = turn;
+    }
+
+    if (cmd->buttons != prev->buttons)
+    {
+	*flags |= NET_TICDIFF_BUTTONS;
+	*p++ = cmd->buttons;
+    }
+
+    if (cmd->consistancy != prev->consistancy)
+    {
+	*flags |= NET_TICDIFF_CONSISTANCY;
+	*p++ = cmd->consistancy;
+    }
+
+    if (cmd->chatchar != prev->chatchar)
+    {
+	*flags |= NET_TICDIFF_CHATCHAR;
+	*p++ = cmd->chatchar;
+    }
+
+    return p;
+}
+
+//
+// NET_SerialReadTiccmd
+// Returns NULL if the ticcmd runs past end.
+//
+static byte *NET_SerialReadTiccmd (byte *p, byte *end, ticcmd_t *cmd,
+				   ticcmd_t *prev)
+{
+    unsigned int	turn;
+    int			shift;
+    int			flags;
+
+    *cmd = *prev;
+
+    if (p >= end)
+	return NULL;
+
+    flags = *p++;
+
+    // one byte for each flag but the turn, which takes one or more
+    if (end - p < ((flags & NET_TICDIFF_FORWARD) != 0)
+		+ ((flags & NET_TICDIFF_SIDE) != 0)
+		+ ((flags & NET_TICDIFF_TURN) != 0)
+		+ ((flags & NET_TICDIFF_BUTTONS) != 0)
+		+ ((flags & NET_TICDIFF_CONSISTANCY) != 0)
+		+ ((flags & NET_TICDIFF_CHATCHAR) != 0))
+    {
+	return NULL;
+    }
+
+    if (flags & NET_TICDIFF_FORWARD)
+	cmd->forwardmove = (signed char) *p++;
+
+    if (flags & NET_TICDIFF_SIDE)
+	cmd->sidemove = (signed char) *p++;
+
+    if (flags & NET_TICDIFF_TURN)
+    {
+	turn = 0;
+
+	for (shift = 0 ; ; shift += 7)
+	{
+	    if (p >= end || shift > 14)
+		return NULL;
+
+	    turn |= (*p & 0x7f) << shift;
+
+	    if (!(*p++ & 0x80))
+		break;
+	}
+
+	if (turn & 1)
+	    cmd->angleturn = (short) (prev->angleturn - (int) ((turn + 1) >> 1));
+	else
+	    cmd->angleturn = (short) (prev->angleturn + (int) (turn >> 1));
+
+	if (end - p < ((flags & NET_TICDIFF_BUTTONS) != 0)
+		    + ((flags & NET_TICDIFF_CONSISTANCY) != 0)
+		    + ((flags & NET_TICDIFF_CHATCHAR) != 0))
+	{
+	    return NULL;
+	}
+    }
+
+    if (flags & NET_TICDIFF_BUTTONS)
+	cmd->buttons = *p++;
+
+    if (flags & NET_TICDIFF_CONSISTANCY)
+	cmd->consistancy = *p++;
+
+    if (flags & NET_TICDIFF_CHATCHAR)
+	cmd->chatchar = *p++;
+
+    return p;
+}
+
+//
+// NET_SerialSameTiccmd
+//
+static boolean NET_SerialSameTiccmd (ticcmd_t *a, ticcmd_t *b)
+{
+    return a->forwardmove == b->forwardmove
+	&& a->sidemove == b->sidemove
+	&& a->angleturn == b->angleturn
+	&& a->chatchar == b->chatchar
+	&& a->buttons == b->buttons
+	&& a->consistancy == b->consistancy;
+}
+
+//
+// NET_SerialExpandTic
+// Tic numbers go out as their low 8 bits, and are put back
+// together against a tic known to be less than half of
+// BACKUPTICS away.
+//
+static int NET_SerialExpandTic (int low, int base)
+{
+    int		delta;
+
+    delta = (low - base) & 0xff;
+
+    if (delta >= 0x80)
+	delta -= 0x100;
+
+    return base + delta;
+}
+
+//
+// NET_SerialSendHello
+//
+static void NET_SerialSendHello (serialnode_t *node)
+{
+    byte	buffer[8];
+
+    buffer[0] = pkt_hello;
+    memcpy (buffer + 1, node->idstr, 6);
+    buffer[7] = node->stage;
+
+    NET_SerialWritePacket (node, buffer, sizeof(buffer));
+    node->lasthello = NET_SerialTime ();
+}
+
+//
+// NET_SerialSendTics
+// Sends the newest tic and serial_extratics before it, or with
+// resend, every tic the other end has not acknowledged yet.
+//
+static void NET_SerialSendTics (serialnode_t *node, boolean resend)
+{
+    static ticcmd_t	emptycmd;
+    byte		buffer[4 + SERIAL_MAXTICS*MAXTICCMDSIZE];
+    byte*		p;
+    ticcmd_t*		prev;
+    int			starttic;
+    int			numtics;
+    int			i;
+
+    starttic = node->maketic - 1 - serial_extratics;
+
+    if (resend || starttic < node->remoteack)
+	starttic = node->remoteack;
+
+    numtics = node->maketic - starttic;
+
+    if (numtics > SERIAL_MAXTICS)
+	numtics = SERIAL_MAXTICS;
+
+    p = buffer;
+    *p++ = pkt_tics;
+    *p++ = node->recvtic & 0xff;
+    *p++ = starttic & 0xff;
+    *p++ = numtics;
+
+    // the other end has the tic before the first, to code it against
+    if (starttic > 0)
+	prev = &node->sendcmds[(starttic - 1) % BACKUPTICS];
+    else
+	prev = &emptycmd;
+
+    for (i=0 ; i<numtics ; i++)
+    {
+	p = NET_SerialWriteTiccmd
+	    (p, &node->sendcmds[(starttic + i) % BACKUPTICS], prev);
+	prev = &node->sendcmds[(starttic + i) % BACKUPTICS];
+    }
+
+    NET_SerialWritePacket (node, buffer, p - buffer);
+
+    node->sendtic = node->maketic;
+    node->ackedtic = node->recvtic;
+    node->lastsend = NET_SerialTime ();
+
+    if (resend)
+	node->lastresend = NET_SerialTime ();
+}
+
+//
+// NET_SerialLoopbackTic
+// The stand-in player makes a tic for each one it is sent, so
+// it keeps pace with this end.  It stands still, or in a
+// simulation plays the other half of the commands, and takes
+// its consistancy checks from the game it is playing against.
+//
+static void NET_SerialLoopbackTic (serialnode_t *node)
+{
+    ticcmd_t*	cmd;
+
+    cmd = &node->sendcmds[node->maketic % BACKUPTICS];
+
+    if (simcmds)
+	*cmd = simcmds[(node->maketic + simnumtics / 2) % simnumtics];
+    else
+	memset (cmd, 0, sizeof(*cmd));
+
+    cmd->consistancy = loopchecks[node->maketic % BACKUPTICS];
+
+    node->maketic++;
+}
+
+//
+// NET_SerialReceiveTic
+//
+static void NET_SerialReceiveTic (serialnode_t *node, ticcmd_t *cmd)
+{
+    ticcmd_t	ticcmds[NET_MAXPLAYERS];
+    boolean	ingame[NET_MAXPLAYERS];
+
+    if (node == &loopnode)
+    {
+	NET_SerialLoopbackTic (node);
+	return;
+    }
+
+    // the ends of NET_SerialSimulate just check what they get:
+    // the other end sends from the other half of the demo
+    if (node != &localnode)
+    {
+	if (!NET_SerialSameTiccmd (cmd, &simcmds[(node->recvtic - 1
+			+ (!node->player) * simnumtics / 2) % simnumtics]))
+	{
+	    I_Error ("NET_SerialSimulate: tic %i came out different "
+		     "from how it went in", node->recvtic - 1);
+	}
+
+	return;
+    }
+
+    memset (ticcmds, 0, sizeof(ticcmds));
+    memset (ingame, 0, sizeof(ingame));
+
+    ticcmds[!node->player] = *cmd;
+    ingame[0] = ingame[1] = true;
+
+    D_ReceiveTic (ticcmds, ingame);
+}
+
+//
+// NET_SerialParseHello
+//
+static void NET_SerialParseHello (serialnode_t *node)
+{
+    int		remotestage;
+
+    if (node->packetlen != 8)
+	return;
+
+    if (!strncmp ((char *) node->packet + 1, node->idstr, 6))
+    {
+	I_Error ("NET_SerialConnect: both ends have id %s; set "
+		 "serial_player to tell them apart", node->idstr);
+    }
+
+    memcpy (node->remoteidstr, node->packet + 1, 6);
+    node->remoteidstr[6] = '\0';
+    remotestage = node->packet[7];
+
+    if (node->stage < 2)
+    {
+	node->stage = remotestage + 1;
+
+	// decide who is who
+	if (strcmp (node->remoteidstr, node->idstr) > 0)
+	    node->player = 0;
+	else
+	    node->player = 1;
+    }
+    else if (remotestage >= 2)
+    {
+	// the other end is connected too
+	return;
+    }
+
+    NET_SerialSendHello (node);
+}
+
+//
+// NET_SerialParseTics
+//
+static void NET_SerialParseTics (serialnode_t *node)
+{
+    static ticcmd_t	emptycmd;
+    ticcmd_t		cmd;
+    ticcmd_t*		prev;
+    byte*		p;
+    byte*		end;
+    int			ack;
+    int			starttic;
+    int			numtics;
+    int			i;
+
+    if (node->packetlen < 4)
+	return;
+
+    p = node->packet + 1;
+    end = node->packet + node->packetlen;
+    ack = NET_SerialExpandTic (p[0], node->remoteack);
+    starttic = NET_SerialExpandTic (p[1], node->recvtic);
+    numtics = p[2];
+    p += 3;
+
+    if (ack > node->remoteack && ack <= node->maketic)
+    {
+	node->remoteack = ack;
+	node->lastack = NET_SerialTime ();
+    }
+
+    // the tics are coded against the one before the first, which
+    // must be one we have
+    if (starttic > node->recvtic || starttic < node->recvtic - BACKUPTICS + 1)
+	return;
+
+    if (starttic > 0)
+	prev = &node->recvcmds[(starttic - 1) % BACKUPTICS];
+    else
+	prev = &emptycmd;
+
+    for (i=0 ; i<numtics ; i++)
+    {
+	p = NET_SerialReadTiccmd (p, end, &cmd, prev);
+
+	if (p == NULL)
+	    return;
+
+	prev = &node->recvcmds[(starttic + i) % BACKUPTICS];
+
+	// already had: if it was sent again, the acknowledgement
+	// for it went missing, so send another
+	if (starttic + i != node->recvtic)
+	{
+	    if (starttic + numtics <= node->recvtic)
+		node->ackedtic = -1;
+
+	    continue;
+	}
+
+	*prev = cmd;
+	node->recvtic++;
+
+	NET_SerialReceiveTic (node, &cmd);
+    }
+}
+
+//
+// NET_SerialRunNode
+//
+static void NET_SerialRunNode (serialnode_t *node)
+{
+    int		nowtime;
+
+    I_PollSerialPort (node->port);
+
+    while (NET_SerialReadPacket (node))
+    {
+	node->lastrecv = NET_SerialTime ();
+
+	switch (node->packet[0])
+	{
+	  case pkt_hello:
+	    NET_SerialParseHello (node);
+	    break;
+
+	  case pkt_tics:
+	    if (node->stage >= 2)
+		NET_SerialParseTics (node);
+	    break;
+
+	  case pkt_quit:
+	    node->quit = true;
+	    break;
+	}
+    }
+
+    nowtime = NET_SerialTime ();
+
+    if (node->stage < 2)
+    {
+	if (nowtime - node->lasthello >= SERIAL_HELLOMS)
+	    NET_SerialSendHello (node);
+
+	return;
+    }
+
+    // acknowledgements ride along with new tics, unless there
+    // have been none for a while
+    if (node->maketic > node->sendtic
+     || (node->recvtic != node->ackedtic
+	 && nowtime - node->lastsend >= SERIAL_RESENDMS))
+    {
+	NET_SerialSendTics (node, false);
+    }
+
+    // a tic went missing with all the packets it rode in when the
+    // other end stops acknowledging
+    if (node->remoteack < node->maketic
+     && nowtime - node->lastack >= SERIAL_RESENDMS
+     && nowtime - node->lastresend >= SERIAL_RESENDMS)
+    {
+	NET_SerialSendTics (node, true);
+    }
+}
+
+//
+// NET_SerialInitNode
+//
+static void NET_SerialInitNode (serialnode_t *node, serialport_t *port,
+				int idnum)
+{
+    memset (node, 0, sizeof(*node));
+
+    node->port = port;
+    node->lasthello = NET_SerialTime () - SERIAL_HELLOMS;
+    node->lastack = NET_SerialTime ();
+
+    M_snprintf (node->idstr, sizeof(node->idstr), "%06i", idnum);
+}
+
+//
+// NET_SerialConnect
+//
+boolean NET_SerialConnect (void)
+{
+    serialport_t*	port;
+    serialport_t*	a;
+    serialport_t*	b;
+    int			idnum;
+    int			start;
+
+    // allow override of automatic player ordering, to allow a
+    // slower board to be set as player 1 always
+    if (serial_player == 1)
+	idnum = 0;
+    else if (serial_player == 2)
+	idnum = 999999;
+    else
+	idnum = (int) (I_GetCycles () % 1000000);
+
+    switch (serial_link)
+    {
+      case seriallink_uart:
+	port = I_OpenSerialPort (serial_baud);
+
+	if (port == NULL)
+	    I_Error ("NET_SerialConnect: no UART for the link; build with "
+		     "-DSERIAL_UART_BASE set to a second UART");
+
+	NET_SerialInitNode (&localnode, port, idnum);
+	break;
+
+      case seriallink_loopback:
+	I_OpenSerialPipe (&a, &b, serial_latency, serial_loss, NET_SerialTime);
+	NET_SerialInitNode (&localnode, a, idnum);
+	NET_SerialInitNode (&loopnode, b, 999999 - idnum);
+	loopback = true;
+	break;
+
+      default:
+	return false;
+    }
+
+    printf ("NET_SerialConnect: attempting to connect across the serial "
+	    "link, id %s\n", localnode.idstr);
+
+    start = I_GetClockMS ();
+
+    while (localnode.stage < 2 || (loopback && loopnode.stage < 2))
+    {
+	if (loopback)
+	    NET_SerialRunNode (&loopnode);
+
+	NET_SerialRunNode (&localnode);
+
+	if (I_GetClockMS () - start > SERIAL_CONNECTMS)
+	    I_Error ("NET_SerialConnect: no answer from the other end");
+    }
+
+    localnode.lastrecv = NET_SerialTime ();
+
+    connected = true;
+    net_client_connected = true;
+
+    printf ("NET_SerialConnect: connected to %s, player %i\n",
+	    localnode.remoteidstr, localnode.player + 1);
+
+    return true;
+}
+
+//
+// NET_SerialConsolePlayer
+//
+int NET_SerialConsolePlayer (void)
+{
+    return localnode.player;
+}
+
+//
+// NET_SerialRun
+//
+void NET_SerialRun (void)
+{
+    if (!connected)
+	return;
+
+    if (loopback)
+	NET_SerialRunNode (&loopnode);
+
+    NET_SerialRunNode (&localnode);
+
+    if (localnode.quit
+     || NET_SerialTime () - localnode.lastrecv > SERIAL_TIMEOUTMS)
+    {
+	printf ("NET_SerialRun: the other end %s\n",
+		localnode.quit ? "left" : "stopped answering");
+
+	connected = false;
+	net_client_connected = false;
+
+	D_ReceiveTic (NULL, NULL);
+    }
+}
+
+//
+// NET_SerialSendTiccmd
+//
+void NET_SerialSendTiccmd (ticcmd_t *cmd, int maketic)
+{
+    if (!connected)
+	return;
+
+    localnode.sendcmds[maketic % BACKUPTICS] = *cmd;
+    localnode.maketic = maketic + 1;
+
+    if (loopback)
+    {
+	loopchecks[maketic % BACKUPTICS]
+	    = consistancy[loopnode.player][maketic % BACKUPTICS];
+    }
+
+    NET_SerialSendTics (&localnode, false);
+}
+
+//
+// NET_SerialDisconnect
+//
+void NET_SerialDisconnect (void)
+{
+    byte	quit;
+    int		start;
+    int		i;
+
+    if (!connected)
+	return;
+
+    quit = pkt_quit;
+
+    for (i=0 ; i<3 ; i++)
+	NET_SerialWritePacket (&localnode, &quit, 1);
+
+    // let it go out before the port stops being polled
+    start = I_GetClockMS ();
+
+    while (!I_SerialSent (localnode.port) && I_GetClockMS () - start < 1000)
+	I_PollSerialPort (localnode.port);
+
+    if (localnode.maketic > 0)
+    {
+	printf ("NET_SerialDisconnect: %i tics, %i bytes sent, %i per 100 "
+		"tics\n", localnode.maketic, localnode.bytessent,
+		localnode.bytessent * 100 / localnode.maketic);
+    }
+
+    if (loopback)
+    {
+	I_CloseSerialPort (localnode.port);
+	I_CloseSerialPort (loopnode.port);
+	loopback = false;
+    }
+
+    connected = false;
+    net_client_connected = false;
+    simulating = false;
+    simcmds = NULL;
+}
+
+//
+// NET_SerialSimulate
+// Plays two ends against each other down a pipe with
+// serial_latency and serial_loss, on a simulated clock, each
+// sending one half of cmds from the start of the other.  Each
+// end makes tics and runs them the way NetUpdate and TryRunTics
+// do with the Vanilla sync, so a tic it cannot make because it
+// is too far ahead of the game is a stall.  Returns the bytes
+// sent and the tics stalled by both ends.
+//
+void NET_SerialSimulate (ticcmd_t *cmds, int numtics, int *bytes,
+			 int *stalls)
+{
+    serialnode_t*	nodes[2];
+    serialport_t*	ports[2];
+    int			gametics[2];
+    int			lasttime[2];
+    int			nowtime;
+    int			newtics;
+    int			endtime;
+    int			i;
+
+    *bytes = *stalls = 0;
+
+    if (numtics < 2)
+	return;
+
+    simulating = true;
+    simtime = 0;
+    simcmds = cmds;
+    simnumtics = numtics;
+
+    I_OpenSerialPipe (&ports[0], &ports[1], serial_latency, serial_loss,
+		      NET_SerialTime);
+
+    // give up on a link too lossy to ever get to the end
+    endtime = (numtics * 1000 / TICRATE) * 10 + 60 * 1000;
+
+    for (i=0 ; i<2 ; i++)
+    {
+	nodes[i] = Z_Malloc (sizeof(serialnode_t), PU_STATIC, NULL);
+	NET_SerialInitNode (nodes[i], ports[i], i);
+
+	// already connected
+	nodes[i]->stage = 2;
+	nodes[i]->player = i;
+
+	gametics[i] = 0;
+	lasttime[i] = 0;
+    }
+
+    while ((gametics[0] < numtics || gametics[1] < numtics)
+	   && simtime < endtime)
+    {
+	for (i=0 ; i<2 ; i++)
+	{
+	    nowtime = simtime * TICRATE / 1000;
+	    newtics = nowtime - lasttime[i];
+	    lasttime[i] = nowtime;
+
+	    for ( ; newtics > 0 && nodes[i]->maketic < numtics ; newtics--)
+	    {
+		if (nodes[i]->maketic - gametics[i] >= 5)
+		{
+		    *stalls += newtics;
+		    break;
+		}
+
+		nodes[i]->sendcmds[nodes[i]->maketic % BACKUPTICS]
+		    = cmds[(nodes[i]->maketic + i * numtics / 2) % numtics];
+		nodes[i]->maketic++;
+	    }
+
+	    NET_SerialRunNode (nodes[i]);
+
+	    while (gametics[i] < nodes[i]->maketic
+		&& gametics[i] < nodes[i]->recvtic)
+	    {
+		gametics[i]++;
+	    }
+	}
+
+	simtime++;
+    }
+
+    if (simtime >= endtime)
+	printf ("NET_SerialSimulate: the link never got to the end\n");
+
+    *bytes = nodes[0]->bytessent + nodes[1]->bytessent;
+
+    for (i=0 ; i<2 ; i++)
+    {
+	I_CloseSerialPort (ports[i]);
+	Z_Free (nodes[i]);
+    }
+
+    simulating = false;
+    simcmds = NULL;
+}
+
+//
+// NET_SerialSimulateConnect
+// Connects to the stand-in down a pipe with serial_latency and
+// serial_loss, with the clock stopped at 0.
+//
+void NET_SerialSimulateConnect (ticcmd_t *cmds, int numtics)
+{
+    serialport_t*	a;
+    serialport_t*	b;
+
+    simulating = true;
+    simtime = 0;
+    simcmds = cmds;
+    simnumtics = numtics;
+
+    I_OpenSerialPipe (&a, &b, serial_latency, serial_loss, NET_SerialTime);
+    NET_SerialInitNode (&localnode, a, 0);
+    NET_SerialInitNode (&loopnode, b, 1);
+
+    // already connected
+    localnode.stage = loopnode.stage = 2;
+    localnode.player = 0;
+    loopnode.player = 1;
+
+    loopback = true;
+    connected = true;
+    net_client_connected = true;
+}
+
+//
+// NET_SerialSimulateTime
+//
+void NET_SerialSimulateTime (int ms)
+{
+    simtime = ms;
+}
@@ -0,0 +1,78 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Two player netgame over a serial line.
+//
+
+#ifndef NET_SERIAL_H
+#define NET_SERIAL_H
+
+#include "doomtype.h"
+#include "d_ticcmd.h"
+
+typedef enum
+{
+    seriallink_none,
+    seriallink_uart,		// the other board is on the UART
+    seriallink_loopback,	// a stand-in player down an in-memory pipe
+} seriallink_t;
+
+extern int serial_link;
+extern int serial_baud;
+extern int serial_player;
+extern int serial_latency;
+extern int serial_loss;
+extern int serial_extratics;
+
+// Waits for the other end and works out who is player 0 and
+// who is player 1.  Returns false if there is no serial link.
+
+boolean NET_SerialConnect (void);
+
+// Player number of this end, once connected.
+
+int NET_SerialConsolePlayer (void);
+
+// Sends and receives, and hands complete tics to D_ReceiveTic.
+
+void NET_SerialRun (void);
+
+// Queues the ticcmd for a new local tic to be sent.
+
+void NET_SerialSendTiccmd (ticcmd_t *cmd, int maketic);
+
+// Tells the other end we are leaving.
+
+void NET_SerialDisconnect (void);
+
+// Plays two ends against each other down a simulated link,
+// each sending half of cmds, and counts the bytes sent and the
+// tics stalled.
+
+void NET_SerialSimulate (ticcmd_t *cmds, int numtics, int *bytes,
+			 int *stalls);
+
+// Connects this end to the stand-in player down a simulated link,
+// as the loopback does, but with the stand-in playing cmds from
+// halfway through.  The link runs until NET_SerialDisconnect.
+
+void NET_SerialSimulateConnect (ticcmd_t *cmds, int numtics);
+
+// Sets the simulated clock, in milliseconds.
+
+void NET_SerialSimulateTime (int ms);
+
+#endif /* #ifndef NET_SERIAL_H */
+
@@ -818,6 +818,7 @@ void A_SPosAttack (mobj_t* actor)
     A_FaceTarget (actor);
     bangle = actor->angle;
     slope = P_AimLineAttack (actor, bangle, MISSILERANGE);
+    P_BeginVolley (actor, bangle, 255<<20, MISSILERANGE);
 
     for (i=0 ; i<3 ; i++)
     {
@@ -825,6 +826,8 @@ void A_SPosAttack (mobj_t* actor)
 	damage = ((P_Random()%5)+1)*3;
 	P_LineAttack (actor, angle, MISSILERANGE, slope, damage);
     }
+
+    P_EndVolley ();
 }
 
 void A_CPosAttack (mobj_t* actor)
@@ -1808,6 +1811,10 @@ mobj_t*		braintargets[32];
 int		numbraintargets;
 int		braintargeton = 0;
 
+// On easy skills the brain spits every other time.  Like vanilla's
+// static in A_BrainSpit, it is not reset between levels.
+int		braineasy = 0;
+
 void A_BrainAwake (mobj_t* mo)
 {
     thinker_t*	thinker;
@@ -1900,11 +1907,9 @@ void A_BrainSpit (mobj_t*	mo)
 {
     mobj_t*	targ;
     mobj_t*	newmobj;
-    
-    static int	easy = 0;
 	
-    easy ^= 1;
-    if (gameskill <= sk_easy && (!easy))
+    braineasy ^= 1;
+    if (gameskill <= sk_easy && (!braineasy))
 	return;
 		
     // shoot a cube at current target
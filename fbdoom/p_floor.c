@@ -49,6 +49,17 @@ T_MovePlane
 {
     boolean	flag;
     fixed_t	lastpos;
+
+    // heights are about to change
+    P_InvalidateSightCache ();
+
+    // keep the heights from before this tic for the renderer
+    if (sector->interptic != leveltime)
+    {
+	sector->oldfloorheight = sector->floorheight;
+	sector->oldceilingheight = sector->ceilingheight;
+	sector->interptic = leveltime;
+    }
 	
     switch(floorOrCeiling)
     {
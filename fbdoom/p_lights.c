@@ -51,6 +51,7 @@ void T_FireFlicker (fireflicker_t* flick)
 	flick->sector->lightlevel = flick->maxlight - amount;
 
     flick->count = 4;
+    P_SleepThinker (&flick->thinker, &flick->sleeper, &flick->count);
 }
 
 
@@ -104,6 +105,7 @@ void T_LightFlash (lightflash_t* flash)
 	flash->count = (P_Random()&flash->maxtime)+1;
     }
 
+    P_SleepThinker (&flash->thinker, &flash->sleeper, &flash->count);
 }
 
 
@@ -161,6 +163,7 @@ void T_StrobeFlash (strobe_t*		flash)
 	flash->count =flash->darktime;
     }
 
+    P_SleepThinker (&flash->thinker, &flash->sleeper, &flash->count);
 }
 
 
@@ -70,6 +70,13 @@ extern	thinker_t	thinkercap;
 void P_InitThinkers (void);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
+void P_SleepThinker (thinker_t* thinker, sleeper_t* sleeper, int* count);
+void P_WakeThinkers (void);
+void P_ClearThinkers (void);
+mobj_t* P_AllocMobj (void);
+
+extern	int	ticarenaepoch;
+void*	P_TicAlloc (int size);
 
 
 //
@@ -111,6 +118,7 @@ P_SpawnMobj
   mobjtype_t	type );
 
 void 	P_RemoveMobj (mobj_t* th);
+void	P_ResetInterpolation (mobj_t* mobj);
 mobj_t* P_SubstNullMobj (mobj_t* th);
 boolean	P_SetMobjState (mobj_t* mobj, statenum_t state);
 void 	P_MobjThinker (mobj_t* mobj);
@@ -126,6 +134,13 @@ void	P_SpawnPlayerMissile (mobj_t* source, mobjtype_t type);
 //
 void P_NoiseAlert (mobj_t* target, mobj_t* emmiter);
 
+// The spots the boss brain spits cubes at, in turn, and which
+// spit is skipped on easy skills.
+extern mobj_t*	braintargets[32];
+extern int	numbraintargets;
+extern int	braintargeton;
+extern int	braineasy;
+
 
 //
 // P_MAPUTL
@@ -149,14 +164,18 @@ typedef struct
     }			d;
 } intercept_t;
 
-// Extended MAXINTERCEPTS, to allow for intercepts overrun emulation.
+// The intercepts list grows from the tic arena as needed.  The
+// original limit is kept to emulate what overrunning it did to
+// memory in vanilla (see InterceptsOverrun()).
 
 #define MAXINTERCEPTS_ORIGINAL 128
-#define MAXINTERCEPTS          (MAXINTERCEPTS_ORIGINAL + 61)
 
-extern intercept_t	intercepts[MAXINTERCEPTS];
+extern intercept_t*	intercepts;
 extern intercept_t*	intercept_p;
 
+// Number of traces that went past the original limit.
+extern int		interceptoverruns;
+
 typedef boolean (*traverser_t) (intercept_t *in);
 
 fixed_t P_AproxDistance (fixed_t dx, fixed_t dy);
@@ -174,11 +193,37 @@ extern fixed_t		lowfloor;
 void 	P_LineOpening (line_t* linedef);
 
 boolean P_BlockLinesIterator (int x, int y, boolean(*func)(line_t*) );
+boolean P_BlockLinesIteratorBox (int x, int y, fixed_t* box,
+				 boolean(*func)(line_t*) );
 boolean P_BlockThingsIterator (int x, int y, boolean(*func)(mobj_t*) );
 
 #define PT_ADDLINES		1
 #define PT_ADDTHINGS	2
 #define PT_EARLYOUT		4
+#define PT_VOLLEY		8	// a ray of the open volley
+
+// What the rays of a hitscan volley share about a line.
+typedef struct
+{
+    int		stamp;		// volley << 2 | VOLLEY_* class
+    fixed_t	num;		// InterceptLine numerator
+} volleyline_t;
+
+extern volleyline_t*	volleylines;
+
+void
+P_BeginVolley
+( mobj_t*	shooter,
+  angle_t	angle,
+  angle_t	spread,
+  fixed_t	distance );
+
+void	P_EndVolley (void);
+boolean P_InVolley (mobj_t* shooter, angle_t angle, fixed_t distance);
+
+#ifdef TRACEBENCH
+void	P_BenchTraces (void);
+#endif
 
 extern divline_t	trace;
 
@@ -193,6 +238,8 @@ P_PathTraverse
 
 void P_UnsetThingPosition (mobj_t* thing);
 void P_SetThingPosition (mobj_t* thing);
+void P_LinkThingToSector (mobj_t* thing);
+void P_LinkThingToBlock (mobj_t* thing);
 
 
 //
@@ -215,18 +262,33 @@ extern	line_t*		ceilingline;
 //
 // We keep the original limit, to detect what variables in memory were
 // overwritten (see SpechitOverrun())
+//
+// The list itself now grows from the tic arena, so there is no
+// upper limit at all.
 
-#define MAXSPECIALCROSS 		20
 #define MAXSPECIALCROSS_ORIGINAL	8
 
-extern	line_t*	spechit[MAXSPECIALCROSS];
+extern	line_t**	spechit;
 extern	int	numspechit;
 
+// Number of moves that crossed more than the original limit.
+extern	int	spechitoverruns;
+
+// Profiling counters, reported by -timedemo.  The cycle counts
+// are only kept when built with -DCYCLEPROFILE.
+#ifdef CYCLEPROFILE
+extern uint64_t	checkposcycles;
+extern uint64_t	sightcycles;
+#endif
+extern int	sightcachehits;
+extern int	sightcachemisses;
+
 boolean P_CheckPosition (mobj_t *thing, fixed_t x, fixed_t y);
 boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+void	P_InvalidateSightCache (void);
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
@@ -265,7 +327,25 @@ extern int		bmapwidth;
 extern int		bmapheight;	// in mapblocks
 extern fixed_t		bmaporgx;
 extern fixed_t		bmaporgy;	// origin of block map
-extern mobj_t**		blocklinks;	// for thing chains
+
+// A line in a mapblock, with its bounding box alongside.
+typedef struct
+{
+    int		linenum;	// -1 ends the block
+    fixed_t	bbox[4];
+} blockline_t;
+
+// The things in a mapblock, oldest first.
+typedef struct
+{
+    mobj_t**	things;
+    int		numthings;
+    int		maxthings;
+} blockthings_t;
+
+extern int*		blocklineofs;	// per block, into blocklines
+extern blockline_t*	blocklines;	// packed by P_PackBlockmap
+extern blockthings_t*	blockthings;	// for things in blocks
 
 
 
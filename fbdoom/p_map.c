@@ -25,6 +25,7 @@
 #include "m_bbox.h"
 #include "m_random.h"
 #include "i_system.h"
+#include "i_timer.h"
 
 #include "doomdef.h"
 #include "m_argv.h"
@@ -82,9 +83,31 @@ line_t*		ceilingline;
 // keep track of special lines as they are hit,
 // but don't process them until the move is proven valid
 
-line_t*		spechit[MAXSPECIALCROSS];
+line_t**	spechit;
 int		numspechit;
 
+static int	maxspechit;
+static int	spechitepoch = -1;
+
+int		spechitoverruns;
+
+//
+// P_ClearSpechit
+// Empties the spechit list, taking a fresh one from
+// the tic arena if the old one went with the last tic.
+//
+static void P_ClearSpechit (void)
+{
+    if (spechitepoch != ticarenaepoch)
+    {
+	maxspechit = MAXSPECIALCROSS_ORIGINAL * 2;
+	spechit = P_TicAlloc (maxspechit * sizeof(*spechit));
+	spechitepoch = ticarenaepoch;
+    }
+
+    numspechit = 0;
+}
+
 
 
 //
@@ -165,7 +188,7 @@ P_TeleportMove
     tmceilingz = newsubsec->sector->ceilingheight;
 			
     validcount++;
-    numspechit = 0;
+    P_ClearSpechit ();
     
     // stomp on any things contacted
     xl = (tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS)>>MAPBLOCKSHIFT;
@@ -205,10 +228,16 @@ static void SpechitOverrun(line_t *ld);
 //
 boolean PIT_CheckLine (line_t* ld)
 {
-    if (tmbbox[BOXRIGHT] <= ld->bbox[BOXLEFT]
-	|| tmbbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
-	|| tmbbox[BOXTOP] <= ld->bbox[BOXBOTTOM]
-	|| tmbbox[BOXBOTTOM] >= ld->bbox[BOXTOP] )
+    fixed_t*	bbox;
+
+    // most lines are rejected here, so test
+    // the packed copy of the bounding box
+    bbox = linebboxes[ld - lines];
+
+    if (tmbbox[BOXRIGHT] <= bbox[BOXLEFT]
+	|| tmbbox[BOXLEFT] >= bbox[BOXRIGHT]
+	|| tmbbox[BOXTOP] <= bbox[BOXBOTTOM]
+	|| tmbbox[BOXBOTTOM] >= bbox[BOXTOP] )
 	return true;
 
     if (P_BoxOnLineSide (tmbbox, ld) != -1)
@@ -256,11 +285,30 @@ boolean PIT_CheckLine (line_t* ld)
     // if contacted a special line, add it to the list
     if (ld->special)
     {
+        if (numspechit == maxspechit)
+        {
+            line_t**	newspechit;
+            int		i;
+
+            newspechit = P_TicAlloc (2 * maxspechit * sizeof(*spechit));
+
+            for (i=0 ; i<maxspechit ; i++)
+                newspechit[i] = spechit[i];
+
+            spechit = newspechit;
+            maxspechit *= 2;
+        }
+
         spechit[numspechit] = ld;
 	numspechit++;
 
+        if (numspechit == MAXSPECIALCROSS_ORIGINAL + 1)
+        {
+            spechitoverruns++;
+        }
+
         // fraggle: spechits overrun emulation code from prboom-plus
-        if (numspechit > MAXSPECIALCROSS_ORIGINAL)
+        if (numspechit > MAXSPECIALCROSS_ORIGINAL && vanillaoverruns)
         {
             SpechitOverrun(ld);
         }
@@ -374,6 +422,31 @@ boolean PIT_CheckThing (mobj_t* thing)
 // MOVEMENT CLIPPING
 //
 
+#ifdef CYCLEPROFILE
+
+// cycles spent in P_CheckPosition, in profiling builds only
+uint64_t	checkposcycles;
+
+static boolean CheckPosition (mobj_t* thing, fixed_t x, fixed_t y);
+
+boolean
+P_CheckPosition
+( mobj_t*	thing,
+  fixed_t	x,
+  fixed_t	y )
+{
+    uint64_t	start;
+    boolean	result;
+
+    start = I_GetCycles ();
+    result = CheckPosition (thing, x, y);
+    checkposcycles += I_GetCycles () - start;
+
+    return result;
+}
+
+#endif
+
 //
 // P_CheckPosition
 // This is purely informative, nothing is modified
@@ -398,8 +471,13 @@ boolean PIT_CheckThing (mobj_t* thing)
 //  speciallines[]
 //  numspeciallines
 //
+#ifdef CYCLEPROFILE
+static boolean
+CheckPosition
+#else
 boolean
 P_CheckPosition
+#endif
 ( mobj_t*	thing,
   fixed_t	x,
   fixed_t	y )
@@ -434,7 +512,7 @@ P_CheckPosition
     tmceilingz = newsubsec->sector->ceilingheight;
 			
     validcount++;
-    numspechit = 0;
+    P_ClearSpechit ();
 
     if ( tmflags & MF_NOCLIP )
 	return true;
@@ -462,7 +540,7 @@ P_CheckPosition
 
     for (bx=xl ; bx<=xh ; bx++)
 	for (by=yl ; by<=yh ; by++)
-	    if (!P_BlockLinesIterator (bx,by,PIT_CheckLine))
+	    if (!P_BlockLinesIteratorBox (bx,by,tmbbox,PIT_CheckLine))
 		return false;
 
     return true;
@@ -1116,7 +1194,13 @@ P_LineAttack
 {
     fixed_t	x2;
     fixed_t	y2;
+    int		flags;
 	
+    flags = PT_ADDLINES|PT_ADDTHINGS;
+
+    if (P_InVolley (t1, angle, distance))
+	flags |= PT_VOLLEY;
+
     angle >>= ANGLETOFINESHIFT;
     shootthing = t1;
     la_damage = damage;
@@ -1128,7 +1212,7 @@ P_LineAttack
 		
     P_PathTraverse ( t1->x, t1->y,
 		     x2, y2,
-		     PT_ADDLINES|PT_ADDTHINGS,
+		     flags,
 		     PTR_ShootTraverse );
 }
  
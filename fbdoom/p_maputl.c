@@ -22,10 +22,14 @@
 
 
 
+#include "stdio.h"
 #include "stdlib.h"
 
 
+#include "i_system.h"
+#include "i_timer.h"
 #include "m_bbox.h"
+#include "z_zone.h"
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -54,40 +58,40 @@ P_AproxDistance
 
 
 //
-// P_PointOnLineSide
-// Returns 0 or 1
+// PointOnLineGeomSide
+// P_PointOnLineSide on the precalculated line geometry.
 //
-int
-P_PointOnLineSide
+static int
+PointOnLineGeomSide
 ( fixed_t	x,
   fixed_t	y,
-  line_t*	line )
+  linegeom_t*	lg )
 {
     fixed_t	dx;
     fixed_t	dy;
     fixed_t	left;
     fixed_t	right;
 	
-    if (!line->dx)
+    if (!lg->dx)
     {
-	if (x <= line->v1->x)
-	    return line->dy > 0;
+	if (x <= lg->x)
+	    return lg->dy > 0;
 	
-	return line->dy < 0;
+	return lg->dy < 0;
     }
-    if (!line->dy)
+    if (!lg->dy)
     {
-	if (y <= line->v1->y)
-	    return line->dx < 0;
+	if (y <= lg->y)
+	    return lg->dx < 0;
 	
-	return line->dx > 0;
+	return lg->dx > 0;
     }
 	
-    dx = (x - line->v1->x);
-    dy = (y - line->v1->y);
+    dx = (x - lg->x);
+    dy = (y - lg->y);
 	
-    left = FixedMul ( line->dy>>FRACBITS , dx );
-    right = FixedMul ( dy , line->dx>>FRACBITS );
+    left = FixedMul ( lg->dyint , dx );
+    right = FixedMul ( dy , lg->dxint );
 	
     if (right < left)
 	return 0;		// front side
@@ -95,6 +99,20 @@ P_PointOnLineSide
 }
 
 
+//
+// P_PointOnLineSide
+// Returns 0 or 1
+//
+int
+P_PointOnLineSide
+( fixed_t	x,
+  fixed_t	y,
+  line_t*	line )
+{
+    return PointOnLineGeomSide (x, y, &linegeoms[line - lines]);
+}
+
+
 
 //
 // P_BoxOnLineSide
@@ -106,15 +124,18 @@ P_BoxOnLineSide
 ( fixed_t*	tmbox,
   line_t*	ld )
 {
+    linegeom_t*	lg;
     int		p1 = 0;
     int		p2 = 0;
+
+    lg = &linegeoms[ld - lines];
 	
-    switch (ld->slopetype)
+    switch (lg->slopetype)
     {
       case ST_HORIZONTAL:
-	p1 = tmbox[BOXTOP] > ld->v1->y;
-	p2 = tmbox[BOXBOTTOM] > ld->v1->y;
-	if (ld->dx < 0)
+	p1 = tmbox[BOXTOP] > lg->y;
+	p2 = tmbox[BOXBOTTOM] > lg->y;
+	if (lg->dx < 0)
 	{
 	    p1 ^= 1;
 	    p2 ^= 1;
@@ -122,9 +143,9 @@ P_BoxOnLineSide
 	break;
 	
       case ST_VERTICAL:
-	p1 = tmbox[BOXRIGHT] < ld->v1->x;
-	p2 = tmbox[BOXLEFT] < ld->v1->x;
-	if (ld->dy < 0)
+	p1 = tmbox[BOXRIGHT] < lg->x;
+	p2 = tmbox[BOXLEFT] < lg->x;
+	if (lg->dy < 0)
 	{
 	    p1 ^= 1;
 	    p2 ^= 1;
@@ -132,13 +153,13 @@ P_BoxOnLineSide
 	break;
 	
       case ST_POSITIVE:
-	p1 = P_PointOnLineSide (tmbox[BOXLEFT], tmbox[BOXTOP], ld);
-	p2 = P_PointOnLineSide (tmbox[BOXRIGHT], tmbox[BOXBOTTOM], ld);
+	p1 = PointOnLineGeomSide (tmbox[BOXLEFT], tmbox[BOXTOP], lg);
+	p2 = PointOnLineGeomSide (tmbox[BOXRIGHT], tmbox[BOXBOTTOM], lg);
 	break;
 	
       case ST_NEGATIVE:
-	p1 = P_PointOnLineSide (tmbox[BOXRIGHT], tmbox[BOXTOP], ld);
-	p2 = P_PointOnLineSide (tmbox[BOXLEFT], tmbox[BOXBOTTOM], ld);
+	p1 = PointOnLineGeomSide (tmbox[BOXRIGHT], tmbox[BOXTOP], lg);
+	p2 = PointOnLineGeomSide (tmbox[BOXLEFT], tmbox[BOXBOTTOM], lg);
 	break;
     }
 
@@ -280,6 +301,42 @@ P_InterceptVector
 }
 
 
+//
+// InterceptLineNum
+// The numerator of InterceptLine, which only depends
+// on where the trace starts.
+//
+static fixed_t
+InterceptLineNum
+( divline_t*	v2,
+  linegeom_t*	lg )
+{
+    return FixedMul ( (lg->x - v2->x)>>8 ,lg->dy )
+	+FixedMul ( (v2->y - lg->y)>>8, lg->dx );
+}
+
+
+//
+// InterceptLine
+// P_InterceptVector with the precalculated geometry
+// of a linedef as the second divline.
+//
+static fixed_t
+InterceptLine
+( divline_t*	v2,
+  linegeom_t*	lg )
+{
+    fixed_t	den;
+	
+    den = FixedMul (lg->dyfrac,v2->dx) - FixedMul(lg->dxfrac,v2->dy);
+
+    if (den == 0)
+	return 0;
+    
+    return FixedDiv (InterceptLineNum (v2, lg), den);
+}
+
+
 //
 // P_LineOpening
 // Sets opentop and openbottom to the window
@@ -332,6 +389,77 @@ void P_LineOpening (line_t* linedef)
 //
 
 
+//
+// BLOCK THING LISTS
+// Each mapblock keeps an array of its things, oldest first,
+// and P_BlockThingsIterator walks it from the newest, which
+// is the order of vanilla's linked lists.  A thing removed
+// from a block that is being iterated shifts the things
+// above it down, so the iterators in progress are noted here
+// and P_UnlinkFromBlock steps them back to match.
+//
+#define MAXBLOCKITERS	16
+
+typedef struct
+{
+    blockthings_t*	block;
+    int			next;	// index of the next thing to visit
+} blockiter_t;
+
+static blockiter_t	blockiters[MAXBLOCKITERS];
+static int		numblockiters;
+
+static void P_LinkToBlock (blockthings_t* block, mobj_t* thing)
+{
+    mobj_t**	things;
+    int		i;
+
+    if (block->numthings == block->maxthings)
+    {
+	block->maxthings = block->maxthings ? block->maxthings*2 : 4;
+	things = Z_Malloc (block->maxthings*sizeof(*things), PU_LEVEL, 0);
+
+	for (i=0 ; i<block->numthings ; i++)
+	    things[i] = block->things[i];
+
+	if (block->things)
+	    Z_Free (block->things);
+
+	block->things = things;
+    }
+
+    block->things[block->numthings++] = thing;
+}
+
+static void P_UnlinkFromBlock (blockthings_t* block, mobj_t* thing)
+{
+    int		i;
+    int		j;
+
+    for (i=block->numthings-1 ; i>=0 ; i--)
+    {
+	if (block->things[i] == thing)
+	    break;
+    }
+
+    if (i < 0)
+	return;
+
+    for (j=i+1 ; j<block->numthings ; j++)
+	block->things[j-1] = block->things[j];
+
+    block->numthings--;
+
+    // The thing after the removed one (in visiting order)
+    // is now one place down.
+    for (j=0 ; j<numblockiters ; j++)
+    {
+	if (blockiters[j].block == block && i <= blockiters[j].next)
+	    blockiters[j].next--;
+    }
+}
+
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -361,21 +489,13 @@ void P_UnsetThingPosition (mobj_t* thing)
     {
 	// inert things don't need to be in blockmap
 	// unlink from block map
-	if (thing->bnext)
-	    thing->bnext->bprev = thing->bprev;
-	
-	if (thing->bprev)
-	    thing->bprev->bnext = thing->bnext;
-	else
-	{
-	    blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
-	    blocky = (thing->y - bmaporgy)>>MAPBLOCKSHIFT;
+	blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
+	blocky = (thing->y - bmaporgy)>>MAPBLOCKSHIFT;
 
-	    if (blockx>=0 && blockx < bmapwidth
-		&& blocky>=0 && blocky <bmapheight)
-	    {
-		blocklinks[blocky*bmapwidth+blockx] = thing->bnext;
-	    }
+	if (blockx>=0 && blockx < bmapwidth
+	    && blocky>=0 && blocky <bmapheight)
+	{
+	    P_UnlinkFromBlock (&blockthings[blocky*bmapwidth+blockx], thing);
 	}
     }
 }
@@ -394,7 +514,6 @@ P_SetThingPosition (mobj_t* thing)
     sector_t*		sec;
     int			blockx;
     int			blocky;
-    mobj_t**		link;
 
     
     // link into subsector
@@ -428,19 +547,56 @@ P_SetThingPosition (mobj_t* thing)
 	    && blocky>=0
 	    && blocky < bmapheight)
 	{
-	    link = &blocklinks[blocky*bmapwidth+blockx];
-	    thing->bprev = NULL;
-	    thing->bnext = *link;
-	    if (*link)
-		(*link)->bprev = thing;
-
-	    *link = thing;
-	}
-	else
-	{
-	    // thing is off the map
-	    thing->bnext = thing->bprev = NULL;
+	    P_LinkToBlock (&blockthings[blocky*bmapwidth+blockx], thing);
 	}
+
+	// otherwise the thing is off the map
+    }
+}
+
+
+
+//
+// P_LinkThingToSector
+// The sector half of P_SetThingPosition, for a thing whose
+// subsector is already set.  The savegame loader links the
+// sector lists and blocks apart to put them back in order.
+//
+void P_LinkThingToSector (mobj_t* thing)
+{
+    sector_t*	sec;
+
+    sec = thing->subsector->sector;
+
+    thing->sprev = NULL;
+    thing->snext = sec->thinglist;
+
+    if (sec->thinglist)
+	sec->thinglist->sprev = thing;
+
+    sec->thinglist = thing;
+}
+
+
+//
+// P_LinkThingToBlock
+// The blockmap half of P_SetThingPosition.  The thing goes
+// after those already in its block.
+//
+void P_LinkThingToBlock (mobj_t* thing)
+{
+    int		blockx;
+    int		blocky;
+
+    blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
+    blocky = (thing->y - bmaporgy)>>MAPBLOCKSHIFT;
+
+    if (blockx>=0
+	&& blockx < bmapwidth
+	&& blocky>=0
+	&& blocky < bmapheight)
+    {
+	P_LinkToBlock (&blockthings[blocky*bmapwidth+blockx], thing);
     }
 }
 
@@ -469,9 +625,7 @@ P_BlockLinesIterator
   int			y,
   boolean(*func)(line_t*) )
 {
-    int			offset;
-    short*		list;
-    line_t*		ld;
+    blockline_t*	bl;
 	
     if (x<0
 	|| y<0
@@ -481,20 +635,62 @@ P_BlockLinesIterator
 	return true;
     }
     
-    offset = y*bmapwidth+x;
-	
-    offset = *(blockmap+offset);
-
-    for ( list = blockmaplump+offset ; *list != -1 ; list++)
+    for (bl = &blocklines[blocklineofs[y*bmapwidth+x]] ;
+	 bl->linenum != -1 ;
+	 bl++)
     {
-	ld = &lines[*list];
+	if (linevalidcount[bl->linenum] == validcount)
+	    continue; 	// line has already been checked
 
-	if (ld->validcount == validcount)
+	linevalidcount[bl->linenum] = validcount;
+
+	if ( !func(&lines[bl->linenum]) )
+	    return false;
+    }
+    return true;	// everything was checked
+}
+
+
+//
+// P_BlockLinesIteratorBox
+// As P_BlockLinesIterator, but lines whose bounding box
+// misses box are marked checked without calling func,
+// exactly as the box test at the top of PIT_CheckLine
+// would have rejected them.
+//
+boolean
+P_BlockLinesIteratorBox
+( int			x,
+  int			y,
+  fixed_t*		box,
+  boolean(*func)(line_t*) )
+{
+    blockline_t*	bl;
+	
+    if (x<0
+	|| y<0
+	|| x>=bmapwidth
+	|| y>=bmapheight)
+    {
+	return true;
+    }
+    
+    for (bl = &blocklines[blocklineofs[y*bmapwidth+x]] ;
+	 bl->linenum != -1 ;
+	 bl++)
+    {
+	if (linevalidcount[bl->linenum] == validcount)
 	    continue; 	// line has already been checked
 
-	ld->validcount = validcount;
-		
-	if ( !func(ld) )
+	linevalidcount[bl->linenum] = validcount;
+
+	if (box[BOXRIGHT] <= bl->bbox[BOXLEFT]
+	    || box[BOXLEFT] >= bl->bbox[BOXRIGHT]
+	    || box[BOXTOP] <= bl->bbox[BOXBOTTOM]
+	    || box[BOXBOTTOM] >= bl->bbox[BOXTOP])
+	    continue;
+
+	if ( !func(&lines[bl->linenum]) )
 	    return false;
     }
     return true;	// everything was checked
@@ -510,6 +706,8 @@ P_BlockThingsIterator
   int			y,
   boolean(*func)(mobj_t*) )
 {
+    blockthings_t*	block;
+    blockiter_t*	iter;
     mobj_t*		mobj;
 	
     if ( x<0
@@ -520,14 +718,28 @@ P_BlockThingsIterator
 	return true;
     }
     
+    if (numblockiters == MAXBLOCKITERS)
+	I_Error ("P_BlockThingsIterator: nested too deep");
+
+    block = &blockthings[y*bmapwidth+x];
+    iter = &blockiters[numblockiters++];
+    iter->block = block;
+    iter->next = block->numthings - 1;
 
-    for (mobj = blocklinks[y*bmapwidth+x] ;
-	 mobj ;
-	 mobj = mobj->bnext)
+    // Things linked in by func go on the end and are not
+    // visited, as they would be ahead of us in a list.
+    while (iter->next >= 0)
     {
+	mobj = block->things[iter->next--];
+
 	if (!func( mobj ) )
+	{
+	    numblockiters--;
 	    return false;
+	}
     }
+
+    numblockiters--;
     return true;
 }
 
@@ -536,15 +748,293 @@ P_BlockThingsIterator
 //
 // INTERCEPT ROUTINES
 //
-intercept_t	intercepts[MAXINTERCEPTS];
+intercept_t*	intercepts;
 intercept_t*	intercept_p;
 
+static int	maxintercepts;
+static int	interceptsepoch = -1;
+
+int		interceptoverruns;
+
 divline_t 	trace;
 boolean 	earlyout;
+boolean		tracevolley;
 int		ptflags;
 
 static void InterceptsOverrun(int num_intercepts, intercept_t *intercept);
 
+//
+// P_ClearIntercepts
+// Empties the intercepts list, taking a fresh one from
+// the tic arena if the old one went with the last tic.
+//
+static void P_ClearIntercepts (void)
+{
+    if (interceptsepoch != ticarenaepoch)
+    {
+	maxintercepts = MAXINTERCEPTS_ORIGINAL;
+	intercepts = P_TicAlloc (maxintercepts * sizeof(*intercepts));
+	interceptsepoch = ticarenaepoch;
+    }
+
+    intercept_p = intercepts;
+}
+
+//
+// P_NewIntercept
+// Returns the next free slot, doubling the list when full.
+//
+static intercept_t* P_NewIntercept (void)
+{
+    intercept_t*	newintercepts;
+    int			i;
+
+    if (intercept_p == intercepts + maxintercepts)
+    {
+	newintercepts = P_TicAlloc (2 * maxintercepts * sizeof(*intercepts));
+
+	for (i=0 ; i<maxintercepts ; i++)
+	    newintercepts[i] = intercepts[i];
+
+	intercepts = newintercepts;
+	intercept_p = intercepts + maxintercepts;
+	maxintercepts *= 2;
+    }
+
+    return intercept_p;
+}
+
+//
+// P_InsertIntercept
+// Moves the intercept just filled in at intercept_p back
+// to its place in the list, which is kept sorted by frac.
+// It goes after any with the same frac, which is the order
+// the vanilla minimum scan took them in.  The DDA walk adds
+// them mostly in order, so it rarely moves far.
+//
+static void P_InsertIntercept (void)
+{
+    intercept_t		in;
+    intercept_t*	scan;
+
+    in = *intercept_p;
+    scan = intercept_p;
+
+    while (scan > intercepts && scan[-1].frac > in.frac)
+    {
+	*scan = scan[-1];
+	scan--;
+    }
+
+    *scan = in;
+    intercept_p++;
+}
+
+//
+// HITSCAN VOLLEYS
+// A shotgun blast traces many rays from one point, a few
+// degrees apart, so most lines near them are crossed by all
+// of them or by none.  Those are sorted out once per volley,
+// along with the part of the intercept that only depends on
+// the origin, and the rays only test the lines near their
+// edges themselves.  Every ray still gathers its own
+// intercepts in the vanilla order, so what it hits and the
+// overrun emulation do not change.
+//
+#define VOLLEY_TEST	0	// some rays may cross it
+#define VOLLEY_MISS	1	// no ray crosses it
+#define VOLLEY_CROSS	2	// every ray crosses it
+
+volleyline_t*	volleylines;
+
+static mobj_t*	volleyshooter;
+static fixed_t	volleyx;
+static fixed_t	volleyy;
+static angle_t	volleyangle;
+static angle_t	volleyspread;
+static fixed_t	volleydistance;
+static int	volleystamp;
+
+// The trace origin after the block edge nudge in P_PathTraverse,
+// and the traces of the two outermost rays.
+static fixed_t	volleyox;
+static fixed_t	volleyoy;
+static fixed_t	volleydx[2];
+static fixed_t	volleydy[2];
+
+// How far the rays are from being exact rotations of each
+// other: the finesine rounding and the block edge nudge.
+static int	volleyslack;
+
+
+//
+// P_BeginVolley
+// Announces that shooter is about to fire rays of the given
+// distance, at most spread either side of angle.
+//
+void
+P_BeginVolley
+( mobj_t*	shooter,
+  angle_t	angle,
+  angle_t	spread,
+  fixed_t	distance )
+{
+    int		edge;
+    int		i;
+
+    // P_VolleySide needs long rays, well under
+    // half a circle apart.
+    if (spread >= ANG45 || distance < 64*FRACUNIT)
+	return;
+
+    volleyshooter = shooter;
+    volleyx = shooter->x;
+    volleyy = shooter->y;
+    volleyangle = angle;
+    volleyspread = spread;
+    volleydistance = distance;
+    volleystamp++;
+
+    volleyox = volleyx;
+    volleyoy = volleyy;
+    volleyslack = distance>>FRACBITS;
+
+    if ( ((volleyox-bmaporgx)&(MAPBLOCKSIZE-1)) == 0)
+    {
+	volleyox += FRACUNIT;
+	volleyslack += FRACUNIT;
+    }
+
+    if ( ((volleyoy-bmaporgy)&(MAPBLOCKSIZE-1)) == 0)
+    {
+	volleyoy += FRACUNIT;
+	volleyslack += FRACUNIT;
+    }
+
+    for (i=0 ; i<2 ; i++)
+    {
+	if (i == 0)
+	    edge = (angle - spread) >> ANGLETOFINESHIFT;
+	else
+	    edge = (angle + spread) >> ANGLETOFINESHIFT;
+
+	volleydx[i] = volleyx + (distance>>FRACBITS)*finecosine[edge]
+		    - volleyox;
+	volleydy[i] = volleyy + (distance>>FRACBITS)*finesine[edge]
+		    - volleyoy;
+    }
+}
+
+
+//
+// P_EndVolley
+//
+void P_EndVolley (void)
+{
+    volleyshooter = NULL;
+}
+
+
+//
+// P_InVolley
+// Returns true if a ray belongs to the open volley.
+//
+boolean
+P_InVolley
+( mobj_t*	shooter,
+  angle_t	angle,
+  fixed_t	distance )
+{
+    return shooter == volleyshooter
+	&& shooter->x == volleyx
+	&& shooter->y == volleyy
+	&& distance == volleydistance
+	&& angle - (volleyangle - volleyspread) <= 2*volleyspread;
+}
+
+
+//
+// P_VolleySide
+// Returns the side P_PointOnDivlineSide puts a point on for
+// every ray of the volley, or -1 if they may not agree.
+//
+// The cross product with a ray only changes sign once in half
+// a circle, and its size is smallest at the ends of an arc
+// that does not change sign, so the two outermost rays decide
+// it.  The margin covers the rays not being exact rotations,
+// counted twice, and the truncation in P_PointOnDivlineSide.
+//
+static int P_VolleySide (fixed_t x, fixed_t y)
+{
+    int64_t	dx;
+    int64_t	dy;
+    int64_t	adx;
+    int64_t	ady;
+    int64_t	margin;
+    int64_t	c1;
+    int64_t	c2;
+
+    dx = (int64_t) x - volleyox;
+    dy = (int64_t) y - volleyoy;
+    adx = dx < 0 ? -dx : dx;
+    ady = dy < 0 ? -dy : dy;
+
+    // keep clear of the wrap around in P_PointOnDivlineSide
+    if (adx >= (1<<30) || ady >= (1<<30))
+	return -1;
+
+    margin = 2*((((adx + ady) * volleyslack) >> 32) + 1)
+	   + (volleydistance >> 23) + 256;
+
+    c1 = (dy * volleydx[0] - dx * volleydy[0]) >> 32;
+    c2 = (dy * volleydx[1] - dx * volleydy[1]) >> 32;
+
+    if (c1 > margin && c2 > margin)
+	return 1;
+
+    if (c1 < -margin && c2 < -margin)
+	return 0;
+
+    return -1;
+}
+
+
+//
+// P_VolleyLine
+// Sorts out a line the first time a ray of the volley
+// comes across it.
+//
+static volleyline_t* P_VolleyLine (int linenum)
+{
+    volleyline_t*	vl;
+    vertexpair_t*	vp;
+    int			s1;
+    int			s2;
+    int			cross;
+
+    vl = &volleylines[linenum];
+
+    if ((vl->stamp >> 2) == volleystamp)
+	return vl;
+
+    vp = &linevertexes[linenum];
+    s1 = P_VolleySide (vp->x1, vp->y1);
+    s2 = P_VolleySide (vp->x2, vp->y2);
+
+    if (s1 < 0 || s2 < 0)
+	cross = VOLLEY_TEST;
+    else if (s1 == s2)
+	cross = VOLLEY_MISS;
+    else
+	cross = VOLLEY_CROSS;
+
+    vl->stamp = (volleystamp << 2) | cross;
+    vl->num = InterceptLineNum (&trace, &linegeoms[linenum]);
+
+    return vl;
+}
+
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -561,29 +1051,49 @@ PIT_AddLineIntercepts (line_t* ld)
     int			s1;
     int			s2;
     fixed_t		frac;
-    divline_t		dl;
-	
-    // avoid precision problems with two routines
-    if ( trace.dx > FRACUNIT*16
-	 || trace.dy > FRACUNIT*16
-	 || trace.dx < -FRACUNIT*16
-	 || trace.dy < -FRACUNIT*16)
-    {
-	s1 = P_PointOnDivlineSide (ld->v1->x, ld->v1->y, &trace);
-	s2 = P_PointOnDivlineSide (ld->v2->x, ld->v2->y, &trace);
-    }
-    else
+    fixed_t		den;
+    int			linenum;
+    vertexpair_t*	vp;
+    linegeom_t*		lg;
+    volleyline_t*	vl;
+
+    linenum = ld - lines;
+    lg = &linegeoms[linenum];
+    vl = tracevolley ? P_VolleyLine (linenum) : NULL;
+
+    if (vl && (vl->stamp & 3) == VOLLEY_MISS)
+	return true;	// no ray of the volley crosses it
+
+    if (!vl || (vl->stamp & 3) == VOLLEY_TEST)
     {
-	s1 = P_PointOnLineSide (trace.x, trace.y, ld);
-	s2 = P_PointOnLineSide (trace.x+trace.dx, trace.y+trace.dy, ld);
-    }
+	// avoid precision problems with two routines
+	if ( trace.dx > FRACUNIT*16
+	     || trace.dy > FRACUNIT*16
+	     || trace.dx < -FRACUNIT*16
+	     || trace.dy < -FRACUNIT*16)
+	{
+	    vp = &linevertexes[linenum];
+	    s1 = P_PointOnDivlineSide (vp->x1, vp->y1, &trace);
+	    s2 = P_PointOnDivlineSide (vp->x2, vp->y2, &trace);
+	}
+	else
+	{
+	    s1 = PointOnLineGeomSide (trace.x, trace.y, lg);
+	    s2 = PointOnLineGeomSide (trace.x+trace.dx, trace.y+trace.dy, lg);
+	}
     
-    if (s1 == s2)
-	return true;	// line isn't crossed
+	if (s1 == s2)
+	    return true;	// line isn't crossed
+    }
     
     // hit the line
-    P_MakeDivline (ld, &dl);
-    frac = P_InterceptVector (&trace, &dl);
+    if (vl)
+    {
+	den = FixedMul (lg->dyfrac,trace.dx) - FixedMul(lg->dxfrac,trace.dy);
+	frac = den ? FixedDiv (vl->num, den) : 0;
+    }
+    else
+	frac = InterceptLine (&trace, lg);
 
     if (frac < 0)
 	return true;	// behind source
@@ -597,11 +1107,12 @@ PIT_AddLineIntercepts (line_t* ld)
     }
     
 	
+    P_NewIntercept ();
     intercept_p->frac = frac;
     intercept_p->isaline = true;
     intercept_p->d.line = ld;
     InterceptsOverrun(intercept_p - intercepts, intercept_p);
-    intercept_p++;
+    P_InsertIntercept ();
 
     return true;	// continue
 }
@@ -663,11 +1174,12 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     if (frac < 0)
 	return true;		// behind source
 
+    P_NewIntercept ();
     intercept_p->frac = frac;
     intercept_p->isaline = false;
     intercept_p->d.thing = thing;
     InterceptsOverrun(intercept_p - intercepts, intercept_p);
-    intercept_p++;
+    P_InsertIntercept ();
 
     return true;		// keep going
 }
@@ -683,46 +1195,16 @@ P_TraverseIntercepts
 ( traverser_t	func,
   fixed_t	maxfrac )
 {
-    int			count;
-    fixed_t		dist;
-    intercept_t*	scan;
     intercept_t*	in;
 	
-    count = intercept_p - intercepts;
-    
-    in = 0;			// shut up compiler warning
-	
-    while (count--)
+    // the list is already in order
+    for (in = intercepts ; in<intercept_p ; in++)
     {
-	dist = INT_MAX;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
-	{
-	    if (scan->frac < dist)
-	    {
-		dist = scan->frac;
-		in = scan;
-	    }
-	}
-	
-	if (dist > maxfrac)
+	if (in->frac > maxfrac)
 	    return true;	// checked everything in range		
 
-#if 0  // UNUSED
-    {
-	// don't check these yet, there may be others inserted
-	in = scan = intercepts;
-	for ( scan = intercepts ; scan<intercept_p ; scan++)
-	    if (scan->frac > maxfrac)
-		*in++ = *scan;
-	intercept_p = in;
-	return false;
-    }
-#endif
-
         if ( !func (in) )
 	    return false;	// don't bother going farther
-
-	in->frac = INT_MAX;
     }
 	
     return true;		// everything was traversed
@@ -828,7 +1310,14 @@ static void InterceptsOverrun(int num_intercepts, intercept_t *intercept)
 {
     int location;
 
-    if (num_intercepts <= MAXINTERCEPTS_ORIGINAL)
+    if (num_intercepts == MAXINTERCEPTS_ORIGINAL)
+    {
+        // Vanilla's array is full from here on.
+
+        interceptoverruns++;
+    }
+
+    if (num_intercepts <= MAXINTERCEPTS_ORIGINAL || !vanillaoverruns)
     {
         // No overrun
 
@@ -850,6 +1339,160 @@ static void InterceptsOverrun(int num_intercepts, intercept_t *intercept)
 }
 
 
+#ifdef TRACEBENCH
+
+//
+// TRACE BENCHMARK
+// Build with -DTRACEBENCH to record the traces a demo makes
+// and time them again at the end of -timedemo: the gather
+// and sort alone, the whole ordered traversal, and the
+// vanilla minimum scan over the same lists.
+//
+#define MAXBENCHTRACES	4096
+
+typedef struct
+{
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	x2;
+    fixed_t	y2;
+    int		flags;
+} benchtrace_t;
+
+static benchtrace_t	benchtraces[MAXBENCHTRACES];
+static int		numbenchtraces;
+static boolean		benchreplay;
+static int		benchmismatches;
+
+static void
+P_RecordTrace
+( fixed_t	x1,
+  fixed_t	y1,
+  fixed_t	x2,
+  fixed_t	y2,
+  int		flags )
+{
+    benchtrace_t*	bt;
+
+    if (benchreplay || numbenchtraces == MAXBENCHTRACES)
+	return;
+
+    bt = &benchtraces[numbenchtraces++];
+    bt->x1 = x1;
+    bt->y1 = y1;
+    bt->x2 = x2;
+    bt->y2 = y2;
+    bt->flags = flags & ~PT_VOLLEY;	// the volley is long closed
+}
+
+static boolean PTR_BenchStop (intercept_t* in)
+{
+    return false;
+}
+
+static boolean PTR_BenchVisit (intercept_t* in)
+{
+    return true;
+}
+
+//
+// P_BenchScan
+// The vanilla P_TraverseIntercepts, visiting everything.
+// It should take the sorted list in order.
+//
+static void P_BenchScan (void)
+{
+    int			count;
+    fixed_t		dist;
+    intercept_t*	scan;
+    intercept_t*	in;
+    intercept_t*	expect;
+	
+    count = intercept_p - intercepts;
+    in = 0;
+    expect = intercepts;
+	
+    while (count--)
+    {
+	dist = INT_MAX;
+	for (scan = intercepts ; scan<intercept_p ; scan++)
+	{
+	    if (scan->frac < dist)
+	    {
+		dist = scan->frac;
+		in = scan;
+	    }
+	}
+	
+	if (dist > FRACUNIT)
+	    return;
+
+	if (in != expect++)
+	    benchmismatches++;
+
+	in->frac = INT_MAX;
+    }
+}
+
+//
+// P_BenchTraces
+//
+void P_BenchTraces (void)
+{
+    benchtrace_t*	bt;
+    boolean		overruns;
+    uint64_t		start;
+    uint64_t		gather;
+    uint64_t		ordered;
+    uint64_t		scanned;
+    int			numintercepts;
+    int			i;
+
+    // the replay must not write over game state
+    overruns = vanillaoverruns;
+    vanillaoverruns = false;
+    benchreplay = true;
+
+    gather = 0;
+    ordered = 0;
+    scanned = 0;
+    numintercepts = 0;
+    benchmismatches = 0;
+
+    for (i=0, bt=benchtraces ; i<numbenchtraces ; i++, bt++)
+    {
+	start = I_GetCycles ();
+	P_PathTraverse (bt->x1, bt->y1, bt->x2, bt->y2,
+			bt->flags, PTR_BenchStop);
+	gather += I_GetCycles () - start;
+
+	start = I_GetCycles ();
+	P_PathTraverse (bt->x1, bt->y1, bt->x2, bt->y2,
+			bt->flags, PTR_BenchVisit);
+	ordered += I_GetCycles () - start;
+
+	numintercepts += intercept_p - intercepts;
+
+	start = I_GetCycles ();
+	P_BenchScan ();
+	scanned += I_GetCycles () - start;
+    }
+
+    benchreplay = false;
+    vanillaoverruns = overruns;
+
+    printf ("Trace bench: %i traces, %i intercepts, gather %llu, "
+	    "ordered %llu, vanilla scan %llu cycles, %i out of order\n",
+	    numbenchtraces, numintercepts,
+	    (unsigned long long) gather,
+	    (unsigned long long) ordered,
+	    (unsigned long long) scanned,
+	    benchmismatches);
+}
+
+#endif
+
+
 //
 // P_PathTraverse
 // Traces a line from x1,y1 to x2,y2,
@@ -888,9 +1531,14 @@ P_PathTraverse
     int		count;
 		
     earlyout = flags & PT_EARLYOUT;
+    tracevolley = (flags & PT_VOLLEY) != 0;
+
+#ifdef TRACEBENCH
+    P_RecordTrace (x1, y1, x2, y2, flags);
+#endif
 		
     validcount++;
-    intercept_p = intercepts;
+    P_ClearIntercepts ();
 	
     if ( ((x1-bmaporgx)&(MAPBLOCKSIZE-1)) == 0)
 	x1 += FRACUNIT;	// don't side exactly on a line
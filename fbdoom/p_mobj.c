@@ -499,6 +499,24 @@ void P_MobjThinker (mobj_t* mobj)
 }
 
 
+//
+// P_ResetInterpolation
+// Makes the renderer draw a thing where it is now, rather
+// than between its old and new positions.  Used when a thing
+// appears or jumps somewhere in the middle of a tic.
+//
+void P_ResetInterpolation (mobj_t* mobj)
+{
+    mobj->oldx = mobj->x;
+    mobj->oldy = mobj->y;
+    mobj->oldz = mobj->z;
+    mobj->oldangle = mobj->angle;
+
+    if (mobj->player)
+	mobj->player->oldviewz = mobj->player->viewz;
+}
+
+
 //
 // P_SpawnMobj
 //
@@ -513,7 +531,7 @@ P_SpawnMobj
     state_t*	st;
     mobjinfo_t*	info;
 	
-    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+    mobj = P_AllocMobj ();
     memset (mobj, 0, sizeof (*mobj));
     info = &mobjinfo[type];
 	
@@ -555,6 +573,7 @@ P_SpawnMobj
     mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	
     P_AddThinker (&mobj->thinker);
+    P_ResetInterpolation (mobj);
 
     return mobj;
 }
@@ -712,6 +731,7 @@ void P_SpawnPlayer (mapthing_t* mthing)
     p->extralight = 0;
     p->fixedcolormap = 0;
     p->viewheight = VIEWHEIGHT;
+    P_ResetInterpolation (mobj);
 
     // setup gun psprite
     P_SetupPsprites (p);
@@ -218,7 +218,8 @@ typedef struct mobj_s
     int			frame;	// might be ORed with FF_FULLBRIGHT
 
     // Interaction info, by BLOCKMAP.
-    // Links in blocks (if needed).
+    // No longer used; blocks keep arrays of their things
+    // (blockthings), but the savegame format has room.
     struct mobj_s*	bnext;
     struct mobj_s*	bprev;
     
@@ -276,6 +277,13 @@ typedef struct mobj_s
 
     // Thing being chased/attacked for tracers.
     struct mobj_s*	tracer;	
+
+    // Position at the start of the last tic, for the
+    // renderer to interpolate from in uncapped mode.
+    fixed_t		oldx;
+    fixed_t		oldy;
+    fixed_t		oldz;
+    angle_t		oldangle;
     
 } mobj_t;
 
@@ -691,9 +691,12 @@ A_FireShotgun
 		  weaponinfo[player->readyweapon].flashstate);
 
     P_BulletSlope (player->mo);
+    P_BeginVolley (player->mo, player->mo->angle, 255<<18, MISSILERANGE);
 	
     for (i=0 ; i<7 ; i++)
 	P_GunShot (player->mo, false);
+
+    P_EndVolley ();
 }
 
 
@@ -721,6 +724,7 @@ A_FireShotgun2
 		  weaponinfo[player->readyweapon].flashstate);
 
     P_BulletSlope (player->mo);
+    P_BeginVolley (player->mo, player->mo->angle, 255<<19, MISSILERANGE);
 	
     for (i=0 ; i<20 ; i++)
     {
@@ -732,6 +736,8 @@ A_FireShotgun2
 		      MISSILERANGE,
 		      bulletslope + ((P_Random()-P_Random())<<5), damage);
     }
+
+    P_EndVolley ();
 }
 
 
@@ -19,6 +19,7 @@
 
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 
 #include "dstrings.h"
 #include "deh_main.h"
@@ -31,16 +32,37 @@
 #include "doomstat.h"
 #include "g_game.h"
 #include "m_misc.h"
+#include "m_random.h"
 #include "r_state.h"
 #include "inttypes.h"
 
 #define SAVEGAME_EOF 0x1d
 #define VERSIONSIZE 16 
 
+// Version string of the fast format, which vanilla will refuse.
+// The number after the name goes up when the layout changes.
+
+#define FASTVERSION "fbfast7 %i"
+
 FILE *save_stream;
 int savegamelength;
 boolean savegame_error;
 
+// Write new savegames in the fast format.
+
+int fast_savegames = 1;
+
+// True if the savegame being read or written is in the fast format.
+
+static boolean savegame_fast;
+
+// While a savegame slot or a buffer is open, reads and writes
+// go to its bytes instead of save_stream.
+
+static byte *save_buffer;
+static int save_capacity;
+static int save_pos;
+
 // Get the filename of a temporary file to write the savegame to.  After
 // the file has been successfully saved, it will be renamed to the 
 // real file.
@@ -77,12 +99,310 @@ char *P_SaveGameFile(int slot)
     return filename;
 }
 
+//
+// Savegame slots in the reserved window.  The window is cut
+// into one area more than there are slots, each a header
+// followed by the same bytes a savegame file holds.  The header
+// names the slot the area holds and a generation, so a new save
+// is written in full into an area no slot is using and then
+// takes over the slot by its header alone: whatever a save is
+// cut short by, the slot still holds either the old game or the
+// new one.
+//
+
+#define SAVESLOT_MAGIC		0x32534246	// "FBS2"
+
+// Areas from before the header named its slot, when area n
+// always held slot n.
+
+#define SAVESLOT_OLDMAGIC	0x56534246	// "FBSV"
+
+typedef struct
+{
+    unsigned int	magic;
+    int			length;
+    unsigned int	crc;
+    unsigned short	slot;
+    unsigned short	generation;
+} saveslot_t;
+
+// Keeps the header stores in order around the one that makes an
+// area valid.  The window may be battery-backed memory or a device,
+// whose stores the hart can make visible in any order, so this must
+// be a fence and not only a compiler barrier.
+
+#define SAVESLOT_BARRIER()	__asm__ volatile ("fence w,w" ::: "memory")
+
+static byte *saveslots;
+static int saveslotsize;
+
+// The area P_CreateSaveSlot is writing into.
+
+static int savearea;
+
+static boolean P_InitSaveSlots(void)
+{
+    int size;
+
+    if (saveslots != NULL)
+    {
+        return true;
+    }
+
+    saveslots = I_SaveGameBase(&size);
+    saveslotsize = (size / (NUMSAVESLOTS + 1)) & ~3;
+
+    if (saveslotsize <= (int) sizeof(saveslot_t))
+    {
+        saveslots = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static saveslot_t *P_SaveArea(int area)
+{
+    return (saveslot_t *) (saveslots + area * saveslotsize);
+}
+
+// True if savegames go to slots in memory rather than to files.
+
+boolean P_SaveSlotsAvailable(void)
+{
+    return P_InitSaveSlots();
+}
+
+// Returns the slot an area holds, or -1 if it holds none.  Checks
+// the header, but not the contents.
+
+static int P_SaveAreaSlot(int area)
+{
+    saveslot_t *header;
+
+    header = P_SaveArea(area);
+
+    if (header->length <= 0
+     || header->length > saveslotsize - (int) sizeof(saveslot_t))
+    {
+        return -1;
+    }
+
+    if (header->magic == SAVESLOT_MAGIC && header->slot < NUMSAVESLOTS)
+    {
+        return header->slot;
+    }
+
+    if (header->magic == SAVESLOT_OLDMAGIC && area < NUMSAVESLOTS)
+    {
+        return area;
+    }
+
+    return -1;
+}
+
+// Returns the header of the newest area holding a slot, or NULL
+// if the slot is empty.  Two areas hold the same slot only if a
+// save was cut short just as it took over.
+
+static saveslot_t *P_FindSaveSlot(int slot)
+{
+    saveslot_t *header;
+    saveslot_t *newest;
+    int area;
+
+    newest = NULL;
+
+    for (area=0; area<=NUMSAVESLOTS; ++area)
+    {
+        if (P_SaveAreaSlot(area) != slot)
+        {
+            continue;
+        }
+
+        header = P_SaveArea(area);
+
+        if (newest == NULL
+         || (short) (header->generation - newest->generation) > 0)
+        {
+            newest = header;
+        }
+    }
+
+    return newest;
+}
+
+// Copies the description of the game in a slot, returning false
+// if the slot is empty.
+
+boolean P_ReadSaveSlotDescription(int slot, char *description)
+{
+    saveslot_t *header;
+
+    if (!P_InitSaveSlots())
+    {
+        return false;
+    }
+
+    header = P_FindSaveSlot(slot);
+
+    if (header == NULL)
+    {
+        return false;
+    }
+
+    memcpy(description, header + 1, SAVESTRINGSIZE);
+    description[SAVESTRINGSIZE - 1] = '\0';
+
+    return true;
+}
+
+// Starts reading from a slot.  Fails if it is empty or corrupt.
+
+boolean P_OpenSaveSlot(int slot)
+{
+    saveslot_t *header;
+
+    if (!P_InitSaveSlots())
+    {
+        return false;
+    }
+
+    header = P_FindSaveSlot(slot);
+
+    if (header == NULL)
+    {
+        return false;
+    }
+
+    if (M_CRC32((byte *) (header + 1), header->length) != header->crc)
+    {
+        return false;
+    }
+
+    save_buffer = (byte *) (header + 1);
+    save_capacity = header->length;
+    save_pos = 0;
+
+    return true;
+}
+
+// Starts writing a new save into an area that no slot is using.
+// There is always one, as there is an area more than slots.
+
+boolean P_CreateSaveSlot(void)
+{
+    saveslot_t *header;
+    boolean used[NUMSAVESLOTS + 1];
+    int slot;
+
+    if (!P_InitSaveSlots())
+    {
+        return false;
+    }
+
+    memset(used, 0, sizeof(used));
+
+    for (slot=0; slot<NUMSAVESLOTS; ++slot)
+    {
+        header = P_FindSaveSlot(slot);
+
+        if (header != NULL)
+        {
+            used[((byte *) header - saveslots) / saveslotsize] = true;
+        }
+    }
+
+    savearea = 0;
+
+    while (used[savearea])
+    {
+        ++savearea;
+    }
+
+    header = P_SaveArea(savearea);
+    header->magic = 0;
+    SAVESLOT_BARRIER();
+
+    save_buffer = (byte *) (header + 1);
+    save_capacity = saveslotsize - sizeof(saveslot_t);
+    save_pos = 0;
+
+    return true;
+}
+
+// Makes a completely written save the newest copy of a slot.  The
+// old copy is only let go once the new one is valid.
+
+void P_CommitSaveSlot(int slot)
+{
+    saveslot_t *header;
+    saveslot_t *old;
+
+    old = P_FindSaveSlot(slot);
+    header = P_SaveArea(savearea);
+
+    header->length = save_pos;
+    header->crc = M_CRC32((byte *) (header + 1), save_pos);
+    header->slot = slot;
+    header->generation = old != NULL ? old->generation + 1 : 1;
+    SAVESLOT_BARRIER();
+
+    header->magic = SAVESLOT_MAGIC;
+    SAVESLOT_BARRIER();
+
+    if (old != NULL)
+    {
+        old->magic = 0;
+        SAVESLOT_BARRIER();
+    }
+}
+
+// Starts reading or writing a caller's buffer, as for a slot.
+
+void P_OpenSaveBuffer(byte *buffer, int capacity)
+{
+    save_buffer = buffer;
+    save_capacity = capacity;
+    save_pos = 0;
+}
+
+// Goes back to save_stream after a slot or buffer.
+
+void P_CloseSaveBuffer(void)
+{
+    save_buffer = NULL;
+}
+
+// Bytes read or written so far.
+
+long P_SaveGamePosition(void)
+{
+    if (save_buffer != NULL)
+    {
+        return save_pos;
+    }
+
+    return ftell(save_stream);
+}
+
 // Endian-safe integer read/write functions
 
 static byte saveg_read8(void)
 {
     byte result;
 
+    if (save_buffer != NULL)
+    {
+        if (save_pos < save_capacity)
+        {
+            return save_buffer[save_pos++];
+        }
+
+        savegame_error = true;
+        return 0;
+    }
+
     if (fread(&result, 1, 1, save_stream) < 1)
     {
         if (!savegame_error)
@@ -99,6 +419,20 @@ static byte saveg_read8(void)
 
 static void saveg_write8(byte value)
 {
+    if (save_buffer != NULL)
+    {
+        if (save_pos < save_capacity)
+        {
+            save_buffer[save_pos++] = value;
+        }
+        else
+        {
+            savegame_error = true;
+        }
+
+        return;
+    }
+
     if (fwrite(&value, 1, 1, save_stream) < 1)
     {
         if (!savegame_error)
@@ -154,7 +488,7 @@ static void saveg_read_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = P_SaveGamePosition();
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -170,7 +504,7 @@ static void saveg_write_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = P_SaveGamePosition();
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -181,6 +515,51 @@ static void saveg_write_pad(void)
 }
 
 
+// Whole records, copied in host byte order
+
+static void saveg_read_block(void *data, int length)
+{
+    if (save_buffer != NULL)
+    {
+        if (save_pos + length <= save_capacity)
+        {
+            memcpy(data, save_buffer + save_pos, length);
+            save_pos += length;
+            return;
+        }
+
+        memset(data, 0, length);
+        savegame_error = true;
+        return;
+    }
+
+    if (fread(data, 1, length, save_stream) < length)
+    {
+        savegame_error = true;
+    }
+}
+
+static void saveg_write_block(void *data, int length)
+{
+    if (save_buffer != NULL)
+    {
+        if (save_pos + length <= save_capacity)
+        {
+            memcpy(save_buffer + save_pos, data, length);
+            save_pos += length;
+            return;
+        }
+
+        savegame_error = true;
+        return;
+    }
+
+    if (fwrite(data, 1, length, save_stream) < length)
+    {
+        savegame_error = true;
+    }
+}
+
 // Pointers
 
 static void *saveg_readp(void)
@@ -1341,6 +1720,49 @@ static void saveg_write_glow_t(glow_t *str)
     saveg_write32(str->direction);
 }
 
+//
+// fireflicker_t
+//
+
+static void saveg_read_fireflicker_t(fireflicker_t *str)
+{
+    int sector;
+
+    // thinker_t thinker;
+    saveg_read_thinker_t(&str->thinker);
+
+    // sector_t* sector;
+    sector = saveg_read32();
+    str->sector = &sectors[sector];
+
+    // int count;
+    str->count = saveg_read32();
+
+    // int maxlight;
+    str->maxlight = saveg_read32();
+
+    // int minlight;
+    str->minlight = saveg_read32();
+}
+
+static void saveg_write_fireflicker_t(fireflicker_t *str)
+{
+    // thinker_t thinker;
+    saveg_write_thinker_t(&str->thinker);
+
+    // sector_t* sector;
+    saveg_write32(str->sector - sectors);
+
+    // int count;
+    saveg_write32(str->count);
+
+    // int maxlight;
+    saveg_write32(str->maxlight);
+
+    // int minlight;
+    saveg_write32(str->minlight);
+}
+
 //
 // Write the header for a savegame
 //
@@ -1355,8 +1777,11 @@ void P_WriteSaveGameHeader(char *description)
     for (; i<SAVESTRINGSIZE; ++i)
         saveg_write8(0);
 
+    savegame_fast = fast_savegames != 0;
+
     memset(name, 0, sizeof(name));
-    M_snprintf(name, sizeof(name), "version %i", G_VanillaVersionCode());
+    M_snprintf(name, sizeof(name), savegame_fast ? FASTVERSION : "version %i",
+               G_VanillaVersionCode());
 
     for (i=0; i<VERSIONSIZE; ++i)
         saveg_write8(name[i]);
@@ -1393,8 +1818,11 @@ boolean P_ReadSaveGameHeader(void)
         read_vcheck[i] = saveg_read8();
 
     memset(vcheck, 0, sizeof(vcheck));
+    M_snprintf(vcheck, sizeof(vcheck), FASTVERSION, G_VanillaVersionCode());
+    savegame_fast = strcmp(read_vcheck, vcheck) == 0;
+
     M_snprintf(vcheck, sizeof(vcheck), "version %i", G_VanillaVersionCode());
-    if (strcmp(read_vcheck, vcheck) != 0)
+    if (!savegame_fast && strcmp(read_vcheck, vcheck) != 0)
 	return false;				// bad version 
 
     gameskill = saveg_read8();
@@ -1550,6 +1978,7 @@ void P_UnArchiveWorld (void)
 	sec->tag = saveg_read16();		// needed?
 	sec->specialdata = 0;
 	sec->soundtarget = 0;
+	sec->interptic = -1;
     }
     
     // do lines
@@ -1616,15 +2045,16 @@ void P_ArchiveThinkers (void)
 
 
 //
-// P_UnArchiveThinkers
+// P_RemoveAllThinkers
 //
-void P_UnArchiveThinkers (void)
+static void P_RemoveAllThinkers (void)
 {
-    byte		tclass;
     thinker_t*		currentthinker;
     thinker_t*		next;
-    mobj_t*		mobj;
     
+    // sleeping lights are off the list, and go with the rest
+    P_WakeThinkers ();
+
     // remove all the current thinkers
     currentthinker = thinkercap.next;
     while (currentthinker != &thinkercap)
@@ -1638,7 +2068,19 @@ void P_UnArchiveThinkers (void)
 
 	currentthinker = next;
     }
-    P_InitThinkers ();
+    P_ClearThinkers ();
+}
+
+
+//
+// P_UnArchiveThinkers
+//
+void P_UnArchiveThinkers (void)
+{
+    byte		tclass;
+    mobj_t*		mobj;
+
+    P_RemoveAllThinkers ();
     
     // read in saved thinkers
     while (1)
@@ -1651,7 +2093,7 @@ void P_UnArchiveThinkers (void)
 			
 	  case tc_mobj:
 	    saveg_read_pad();
-	    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+	    mobj = P_AllocMobj ();
             saveg_read_mobj_t(mobj);
 
 	    mobj->target = NULL;
@@ -1662,6 +2104,7 @@ void P_UnArchiveThinkers (void)
 	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
 	    mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
 	    P_AddThinker (&mobj->thinker);
+	    P_ResetInterpolation (mobj);
 	    break;
 
 	  default:
@@ -1685,7 +2128,11 @@ enum
     tc_flash,
     tc_strobe,
     tc_glow,
-    tc_endspecials
+    tc_endspecials,
+
+    // fast format only
+    tc_fireflicker,
+    tc_fastmobj
 
 } specials_e;	
 
@@ -1702,85 +2149,121 @@ enum
 // T_Glow, (glow_t: sector_t *),
 // T_PlatRaise, (plat_t: sector_t *), - active list
 //
-void P_ArchiveSpecials (void)
+static boolean P_ArchiveSpecial (thinker_t* th, boolean fast)
 {
-    thinker_t*		th;
     int			i;
-	
-    // save off the current thinkers
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+
+    if (th->function.acv == (actionf_v)NULL)
     {
-	if (th->function.acv == (actionf_v)NULL)
-	{
-	    for (i = 0; i < MAXCEILINGS;i++)
-		if (activeceilings[i] == (ceiling_t *)th)
-		    break;
+	for (i = 0; i < MAXCEILINGS;i++)
+	    if (activeceilings[i] == (ceiling_t *)th)
+		break;
 	    
-	    if (i<MAXCEILINGS)
-	    {
-                saveg_write8(tc_ceiling);
-		saveg_write_pad();
-                saveg_write_ceiling_t((ceiling_t *) th);
-	    }
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
+	if (i<MAXCEILINGS)
 	{
             saveg_write8(tc_ceiling);
 	    saveg_write_pad();
             saveg_write_ceiling_t((ceiling_t *) th);
-	    continue;
+	    return true;
 	}
-			
-	if (th->function.acp1 == (actionf_p1)T_VerticalDoor)
-	{
-            saveg_write8(tc_door);
-	    saveg_write_pad();
-            saveg_write_vldoor_t((vldoor_t *) th);
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_MoveFloor)
-	{
-            saveg_write8(tc_floor);
-	    saveg_write_pad();
-            saveg_write_floormove_t((floormove_t *) th);
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_PlatRaise)
+
+	// vanilla loses plats in stasis
+	if (!fast)
+	    return false;
+
+	for (i = 0; i < MAXPLATS;i++)
+	    if (activeplats[i] == (plat_t *)th)
+		break;
+
+	if (i<MAXPLATS)
 	{
             saveg_write8(tc_plat);
 	    saveg_write_pad();
             saveg_write_plat_t((plat_t *) th);
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_LightFlash)
-	{
-            saveg_write8(tc_flash);
-	    saveg_write_pad();
-            saveg_write_lightflash_t((lightflash_t *) th);
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
-	{
-            saveg_write8(tc_strobe);
-	    saveg_write_pad();
-            saveg_write_strobe_t((strobe_t *) th);
-	    continue;
-	}
-			
-	if (th->function.acp1 == (actionf_p1)T_Glow)
-	{
-            saveg_write8(tc_glow);
-	    saveg_write_pad();
-            saveg_write_glow_t((glow_t *) th);
-	    continue;
+	    return true;
 	}
+	return false;
     }
+		
+    if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
+    {
+        saveg_write8(tc_ceiling);
+	saveg_write_pad();
+        saveg_write_ceiling_t((ceiling_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_VerticalDoor)
+    {
+        saveg_write8(tc_door);
+	saveg_write_pad();
+        saveg_write_vldoor_t((vldoor_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_MoveFloor)
+    {
+        saveg_write8(tc_floor);
+	saveg_write_pad();
+        saveg_write_floormove_t((floormove_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_PlatRaise)
+    {
+        saveg_write8(tc_plat);
+	saveg_write_pad();
+        saveg_write_plat_t((plat_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_LightFlash)
+    {
+        saveg_write8(tc_flash);
+	saveg_write_pad();
+        saveg_write_lightflash_t((lightflash_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
+    {
+        saveg_write8(tc_strobe);
+	saveg_write_pad();
+        saveg_write_strobe_t((strobe_t *) th);
+	return true;
+    }
+		
+    if (th->function.acp1 == (actionf_p1)T_Glow)
+    {
+        saveg_write8(tc_glow);
+	saveg_write_pad();
+        saveg_write_glow_t((glow_t *) th);
+	return true;
+    }
+
+    // vanilla does not save flickering fire
+    if (fast && th->function.acp1 == (actionf_p1)T_FireFlicker)
+    {
+        saveg_write8(tc_fireflicker);
+	saveg_write_pad();
+        saveg_write_fireflicker_t((fireflicker_t *) th);
+	return true;
+    }
+
+    return false;
+}
+
+void P_ArchiveSpecials (void)
+{
+    thinker_t*		th;
+	
+    // sleeping lights have to be on the list, with
+    // their countdowns up to date
+    P_WakeThinkers ();
+
+    // save off the current thinkers
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	P_ArchiveSpecial (th, false);
 	
     // add a terminating marker
     saveg_write8(tc_endspecials);
@@ -1791,9 +2274,8 @@ void P_ArchiveSpecials (void)
 //
 // P_UnArchiveSpecials
 //
-void P_UnArchiveSpecials (void)
+static boolean P_UnArchiveSpecial (byte tclass)
 {
-    byte		tclass;
     ceiling_t*		ceiling;
     vldoor_t*		door;
     floormove_t*	floor;
@@ -1801,92 +2283,1063 @@ void P_UnArchiveSpecials (void)
     lightflash_t*	flash;
     strobe_t*		strobe;
     glow_t*		glow;
+    fireflicker_t*	flick;
 	
-	
-    // read in saved thinkers
-    while (1)
+    switch (tclass)
     {
-	tclass = saveg_read8();
-
-	switch (tclass)
-	{
-	  case tc_endspecials:
-	    return;	// end of list
+      case tc_endspecials:
+	return false;	// end of list
 			
-	  case tc_ceiling:
-	    saveg_read_pad();
-	    ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
-            saveg_read_ceiling_t(ceiling);
-	    ceiling->sector->specialdata = ceiling;
+      case tc_ceiling:
+	saveg_read_pad();
+	ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
+        saveg_read_ceiling_t(ceiling);
+	ceiling->sector->specialdata = ceiling;
 
-	    if (ceiling->thinker.function.acp1)
-		ceiling->thinker.function.acp1 = (actionf_p1)T_MoveCeiling;
+	if (ceiling->thinker.function.acp1)
+	    ceiling->thinker.function.acp1 = (actionf_p1)T_MoveCeiling;
 
-	    P_AddThinker (&ceiling->thinker);
-	    P_AddActiveCeiling(ceiling);
-	    break;
+	P_AddThinker (&ceiling->thinker);
+	P_AddActiveCeiling(ceiling);
+	break;
 				
-	  case tc_door:
-	    saveg_read_pad();
-	    door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
-            saveg_read_vldoor_t(door);
-	    door->sector->specialdata = door;
-	    door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
-	    P_AddThinker (&door->thinker);
-	    break;
+      case tc_door:
+	saveg_read_pad();
+	door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
+        saveg_read_vldoor_t(door);
+	door->sector->specialdata = door;
+	door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
+	P_AddThinker (&door->thinker);
+	break;
 				
-	  case tc_floor:
-	    saveg_read_pad();
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
-            saveg_read_floormove_t(floor);
-	    floor->sector->specialdata = floor;
-	    floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
-	    P_AddThinker (&floor->thinker);
-	    break;
+      case tc_floor:
+	saveg_read_pad();
+	floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
+        saveg_read_floormove_t(floor);
+	floor->sector->specialdata = floor;
+	floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
+	P_AddThinker (&floor->thinker);
+	break;
 				
-	  case tc_plat:
-	    saveg_read_pad();
-	    plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
-            saveg_read_plat_t(plat);
-	    plat->sector->specialdata = plat;
+      case tc_plat:
+	saveg_read_pad();
+	plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
+        saveg_read_plat_t(plat);
+	plat->sector->specialdata = plat;
 
-	    if (plat->thinker.function.acp1)
-		plat->thinker.function.acp1 = (actionf_p1)T_PlatRaise;
+	if (plat->thinker.function.acp1)
+	    plat->thinker.function.acp1 = (actionf_p1)T_PlatRaise;
 
-	    P_AddThinker (&plat->thinker);
-	    P_AddActivePlat(plat);
-	    break;
+	P_AddThinker (&plat->thinker);
+	P_AddActivePlat(plat);
+	break;
 				
-	  case tc_flash:
-	    saveg_read_pad();
-	    flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
-            saveg_read_lightflash_t(flash);
-	    flash->thinker.function.acp1 = (actionf_p1)T_LightFlash;
-	    P_AddThinker (&flash->thinker);
-	    break;
+      case tc_flash:
+	saveg_read_pad();
+	flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
+        saveg_read_lightflash_t(flash);
+	flash->thinker.function.acp1 = (actionf_p1)T_LightFlash;
+	P_AddThinker (&flash->thinker);
+	break;
 				
-	  case tc_strobe:
-	    saveg_read_pad();
-	    strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
-            saveg_read_strobe_t(strobe);
-	    strobe->thinker.function.acp1 = (actionf_p1)T_StrobeFlash;
-	    P_AddThinker (&strobe->thinker);
-	    break;
+      case tc_strobe:
+	saveg_read_pad();
+	strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
+        saveg_read_strobe_t(strobe);
+	strobe->thinker.function.acp1 = (actionf_p1)T_StrobeFlash;
+	P_AddThinker (&strobe->thinker);
+	break;
 				
-	  case tc_glow:
-	    saveg_read_pad();
-	    glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
-            saveg_read_glow_t(glow);
-	    glow->thinker.function.acp1 = (actionf_p1)T_Glow;
-	    P_AddThinker (&glow->thinker);
-	    break;
+      case tc_glow:
+	saveg_read_pad();
+	glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
+        saveg_read_glow_t(glow);
+	glow->thinker.function.acp1 = (actionf_p1)T_Glow;
+	P_AddThinker (&glow->thinker);
+	break;
+
+      case tc_fireflicker:
+	saveg_read_pad();
+	flick = Z_Malloc (sizeof(*flick), PU_LEVEL, NULL);
+        saveg_read_fireflicker_t(flick);
+	flick->thinker.function.acp1 = (actionf_p1)T_FireFlicker;
+	P_AddThinker (&flick->thinker);
+	break;
 				
-	  default:
-	    I_Error ("P_UnarchiveSpecials:Unknown tclass %i "
-		     "in savegame",tclass);
+      default:
+	I_Error ("P_UnarchiveSpecials:Unknown tclass %i "
+		 "in savegame",tclass);
+    }
+
+    return true;
+}
+
+void P_UnArchiveSpecials (void)
+{
+    // read in saved thinkers
+    while (P_UnArchiveSpecial (saveg_read8()))
+	;
+}
+
+
+//
+// Fast savegame format.  Sectors, lines, sides and mobjs go
+// out as fixed-layout records in host byte order, copied whole.
+// The world is written as just the records that differ from the
+// level as P_SetupLevel left it.  Mobj references are indices
+// into the saved list.  Players and specials are few and use the
+// vanilla routines.
+//
+// Unlike vanilla, it keeps the order of the thinkers, their
+// references, every special and switch timer, the random index
+// and the queues the play simulation reads, and the order of the things in
+// each sector and block, so that a level restored from it plays
+// on exactly as it would have.  The rewind buffer and demo
+// keyframes rely on this.
+//
+
+typedef struct
+{
+    fixed_t	floorheight;
+    fixed_t	ceilingheight;
+    short	floorpic;
+    short	ceilingpic;
+    short	lightlevel;
+    short	special;
+    short	tag;
+    short	pad;
+} savesector_t;
+
+typedef struct
+{
+    short	flags;
+    short	special;
+    short	tag;
+    short	pad;
+} saveline_t;
+
+typedef struct
+{
+    fixed_t	textureoffset;
+    fixed_t	rowoffset;
+    short	toptexture;
+    short	bottomtexture;
+    short	midtexture;
+    short	pad;
+} saveside_t;
+
+typedef struct
+{
+    fixed_t	x;
+    fixed_t	y;
+    fixed_t	z;
+    angle_t	angle;
+    int		sprite;
+    int		frame;
+    fixed_t	floorz;
+    fixed_t	ceilingz;
+    fixed_t	radius;
+    fixed_t	height;
+    fixed_t	momx;
+    fixed_t	momy;
+    fixed_t	momz;
+    int		type;
+    int		tics;
+    int		state;
+    int		flags;
+    int		health;
+    int		movedir;
+    int		movecount;
+    int		reactiontime;
+    int		threshold;
+    int		lastlook;
+
+    // 1 + index into players, or 0
+    int		player;
+
+    // 1 + index into the saved mobjs, or 0
+    int		target;
+    int		tracer;
+
+    // place in the sector's thing list and in the block's
+    // things, or -1 if not linked there
+    int		sectororder;
+    int		blockorder;
+
+    mapthing_t	spawnpoint;
+    short	pad;
+} savemobj_t;
+
+typedef void (*packfunc_t)(void *item, void *rec);
+typedef void (*unpackfunc_t)(void *rec, void *item);
+
+// The world as P_SetupLevel left it.
+
+static savesector_t*	basesectors;
+static saveline_t*	baselines;
+static saveside_t*	basesides;
+
+// Mobjs being saved or loaded, in thinker order.  While saving,
+// each one's validcount, which mobjs do not otherwise use, holds
+// its index here.
+
+static mobj_t**		savemobjs;
+static int		numsavemobjs;
+
+// Two per mobj: its place in its sector's list and in its block.
+
+static int*		savelinks;
+
+static void P_PackSector (void *item, void *rec)
+{
+    sector_t*		sec = item;
+    savesector_t*	r = rec;
+
+    r->floorheight = sec->floorheight;
+    r->ceilingheight = sec->ceilingheight;
+    r->floorpic = sec->floorpic;
+    r->ceilingpic = sec->ceilingpic;
+    r->lightlevel = sec->lightlevel;
+    r->special = sec->special;
+    r->tag = sec->tag;
+    r->pad = 0;
+}
+
+static void P_UnpackSector (void *rec, void *item)
+{
+    savesector_t*	r = rec;
+    sector_t*		sec = item;
+
+    sec->floorheight = r->floorheight;
+    sec->ceilingheight = r->ceilingheight;
+    sec->floorpic = r->floorpic;
+    sec->ceilingpic = r->ceilingpic;
+    sec->lightlevel = r->lightlevel;
+    sec->special = r->special;
+    sec->tag = r->tag;
+}
+
+static void P_PackLine (void *item, void *rec)
+{
+    line_t*		li = item;
+    saveline_t*		r = rec;
+
+    r->flags = li->flags;
+    r->special = li->special;
+    r->tag = li->tag;
+    r->pad = 0;
+}
+
+static void P_UnpackLine (void *rec, void *item)
+{
+    saveline_t*		r = rec;
+    line_t*		li = item;
+
+    li->flags = r->flags;
+    li->special = r->special;
+    li->tag = r->tag;
+}
+
+static void P_PackSide (void *item, void *rec)
+{
+    side_t*		si = item;
+    saveside_t*		r = rec;
+
+    r->textureoffset = si->textureoffset;
+    r->rowoffset = si->rowoffset;
+    r->toptexture = si->toptexture;
+    r->bottomtexture = si->bottomtexture;
+    r->midtexture = si->midtexture;
+    r->pad = 0;
+}
+
+static void P_UnpackSide (void *rec, void *item)
+{
+    saveside_t*		r = rec;
+    side_t*		si = item;
+
+    si->textureoffset = r->textureoffset;
+    si->rowoffset = r->rowoffset;
+    si->toptexture = r->toptexture;
+    si->bottomtexture = r->bottomtexture;
+    si->midtexture = r->midtexture;
+}
+
+//
+// P_SnapshotWorld
+// Keeps the state of a freshly set up level for the fast
+// format to compare against.  Called at the end of P_SetupLevel.
+//
+void P_SnapshotWorld (void)
+{
+    int		i;
+
+    basesectors = Z_Malloc (numsectors * sizeof(*basesectors), PU_LEVEL, NULL);
+    baselines = Z_Malloc (numlines * sizeof(*baselines), PU_LEVEL, NULL);
+    basesides = Z_Malloc (numsides * sizeof(*basesides), PU_LEVEL, NULL);
+
+    for (i=0 ; i<numsectors ; i++)
+	P_PackSector (&sectors[i], &basesectors[i]);
+
+    for (i=0 ; i<numlines ; i++)
+	P_PackLine (&lines[i], &baselines[i]);
+
+    for (i=0 ; i<numsides ; i++)
+	P_PackSide (&sides[i], &basesides[i]);
+}
+
+//
+// P_SameRecord
+// Records are padded to whole words.
+//
+static boolean P_SameRecord (void *a, void *b, int size)
+{
+    int*	wa = a;
+    int*	wb = b;
+    int		i;
+
+    for (i=0 ; i<size/4 ; i++)
+    {
+	if (wa[i] != wb[i])
+	    return false;
+    }
+
+    return true;
+}
+
+//
+// P_ArchiveDelta
+// Writes the count and then the index and record of every item
+// that differs from its base record.
+//
+static void
+P_ArchiveDelta
+( byte*		items,
+  int		itemsize,
+  int		count,
+  byte*		base,
+  int		recsize,
+  packfunc_t	pack )
+{
+    int		rec[8];
+    int		changed;
+    int		i;
+
+    changed = 0;
+
+    for (i=0 ; i<count ; i++)
+    {
+	pack (items + i*itemsize, rec);
+
+	if (!P_SameRecord (rec, base + i*recsize, recsize))
+	    changed++;
+    }
+
+    saveg_write32(changed);
+
+    for (i=0 ; i<count ; i++)
+    {
+	pack (items + i*itemsize, rec);
+
+	if (P_SameRecord (rec, base + i*recsize, recsize))
+	    continue;
+
+	saveg_write32(i);
+	saveg_write_block(rec, recsize);
+    }
+}
+
+//
+// P_UnArchiveDelta
+// Puts every item back to its base record, then applies the
+// records that differ.
+//
+static void
+P_UnArchiveDelta
+( byte*		items,
+  int		itemsize,
+  int		count,
+  byte*		base,
+  int		recsize,
+  unpackfunc_t	unpack )
+{
+    int		rec[8];
+    int		changed;
+    int		index;
+    int		i;
+
+    for (i=0 ; i<count ; i++)
+	unpack (base + i*recsize, items + i*itemsize);
+
+    changed = saveg_read32();
+
+    while (changed-- > 0 && !savegame_error)
+    {
+	index = saveg_read32();
+	saveg_read_block(rec, recsize);
+
+	if (index < 0 || index >= count)
+	    I_Error ("P_UnArchiveDelta: bad index %i in savegame", index);
+
+	unpack (rec, items + index*itemsize);
+    }
+}
+
+//
+// P_ArchiveWorldDelta
+//
+static void P_ArchiveWorldDelta (void)
+{
+    P_ArchiveDelta ((byte *) sectors, sizeof(sector_t), numsectors,
+		    (byte *) basesectors, sizeof(savesector_t), P_PackSector);
+    P_ArchiveDelta ((byte *) lines, sizeof(line_t), numlines,
+		    (byte *) baselines, sizeof(saveline_t), P_PackLine);
+    P_ArchiveDelta ((byte *) sides, sizeof(side_t), numsides,
+		    (byte *) basesides, sizeof(saveside_t), P_PackSide);
+}
+
+//
+// P_UnArchiveWorldDelta
+//
+static void P_UnArchiveWorldDelta (void)
+{
+    sector_t*	sec;
+    int		i;
+
+    P_UnArchiveDelta ((byte *) sectors, sizeof(sector_t), numsectors,
+		      (byte *) basesectors, sizeof(savesector_t),
+		      P_UnpackSector);
+    P_UnArchiveDelta ((byte *) lines, sizeof(line_t), numlines,
+		      (byte *) baselines, sizeof(saveline_t), P_UnpackLine);
+    P_UnArchiveDelta ((byte *) sides, sizeof(side_t), numsides,
+		      (byte *) basesides, sizeof(saveside_t), P_UnpackSide);
+
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	sec->specialdata = 0;
+	sec->soundtarget = 0;
+	sec->interptic = -1;
+    }
+}
+
+//
+// P_IndexLinks
+// Notes where each numbered mobj is in its sector's thing list
+// and in its block, which the order they move in decides.
+//
+static void P_IndexLinks (void)
+{
+    sector_t*		sec;
+    blockthings_t*	block;
+    mobj_t*		mo;
+    int			order;
+    int			i;
+    int			j;
+
+    savelinks = Z_Malloc (numsavemobjs * 2 * sizeof(*savelinks) + 1,
+			  PU_STATIC, NULL);
+
+    for (i=0 ; i<numsavemobjs*2 ; i++)
+	savelinks[i] = -1;
+
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	order = 0;
+
+	for (mo = sec->thinglist ; mo ; mo = mo->snext)
+	    savelinks[mo->validcount*2] = order++;
+    }
+
+    for (i=0, block = blockthings ; i<bmapwidth*bmapheight ; i++,block++)
+    {
+	for (j=0 ; j<block->numthings ; j++)
+	    savelinks[block->things[j]->validcount*2+1] = j;
+    }
+}
+
+//
+// P_IndexMobjs
+// Numbers the mobjs in thinker order before a save.
+//
+static void P_IndexMobjs (void)
+{
+    thinker_t*	th;
+    mobj_t*	mo;
+
+    numsavemobjs = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	    numsavemobjs++;
+    }
+
+    savemobjs = Z_Malloc (numsavemobjs * sizeof(*savemobjs) + 1,
+			  PU_STATIC, NULL);
+    numsavemobjs = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+	    continue;
+
+	mo = (mobj_t *) th;
+	mo->validcount = numsavemobjs;
+	savemobjs[numsavemobjs++] = mo;
+    }
+
+    P_IndexLinks ();
+}
+
+//
+// P_SavedMobjIndex
+// 1 + the index of a mobj in the save, or 0 for none.  A mobj
+// that has been removed from the level counts as none.
+//
+static int P_SavedMobjIndex (mobj_t* mo)
+{
+    if (mo == NULL
+	|| mo->validcount < 0
+	|| mo->validcount >= numsavemobjs
+	|| savemobjs[mo->validcount] != mo)
+    {
+	return 0;
+    }
+
+    return mo->validcount + 1;
+}
+
+//
+// P_LoadedMobj
+//
+static mobj_t* P_LoadedMobj (int index)
+{
+    if (index <= 0 || index > numsavemobjs)
+	return NULL;
+
+    return savemobjs[index - 1];
+}
+
+//
+// P_FreeMobjIndex
+//
+static void P_FreeMobjIndex (void)
+{
+    Z_Free (savemobjs);
+    savemobjs = NULL;
+    numsavemobjs = 0;
+
+    Z_Free (savelinks);
+    savelinks = NULL;
+}
+
+//
+// P_ArchiveMobj
+//
+static void P_ArchiveMobj (mobj_t* mo)
+{
+    savemobj_t	rec;
+
+    rec.x = mo->x;
+    rec.y = mo->y;
+    rec.z = mo->z;
+    rec.angle = mo->angle;
+    rec.sprite = mo->sprite;
+    rec.frame = mo->frame;
+    rec.floorz = mo->floorz;
+    rec.ceilingz = mo->ceilingz;
+    rec.radius = mo->radius;
+    rec.height = mo->height;
+    rec.momx = mo->momx;
+    rec.momy = mo->momy;
+    rec.momz = mo->momz;
+    rec.type = mo->type;
+    rec.tics = mo->tics;
+    rec.state = mo->state - states;
+    rec.flags = mo->flags;
+    rec.health = mo->health;
+    rec.movedir = mo->movedir;
+    rec.movecount = mo->movecount;
+    rec.reactiontime = mo->reactiontime;
+    rec.threshold = mo->threshold;
+    rec.lastlook = mo->lastlook;
+    rec.player = mo->player ? mo->player - players + 1 : 0;
+    rec.target = P_SavedMobjIndex (mo->target);
+    rec.tracer = P_SavedMobjIndex (mo->tracer);
+    rec.sectororder = savelinks[mo->validcount*2];
+    rec.blockorder = savelinks[mo->validcount*2+1];
+    rec.spawnpoint = mo->spawnpoint;
+    rec.pad = 0;
+
+    saveg_write_block(&rec, sizeof(rec));
+}
+
+//
+// P_UnArchiveMobj
+// Returns the mobj's target and tracer indices and its links
+// for when every mobj exists.
+//
+static mobj_t* P_UnArchiveMobj (int *refs, int *links)
+{
+    savemobj_t	rec;
+    mobj_t*	mobj;
+
+    saveg_read_block(&rec, sizeof(rec));
+
+    if (savegame_error
+	|| rec.state < 0 || rec.state >= NUMSTATES
+	|| rec.type < 0 || rec.type >= NUMMOBJTYPES
+	|| rec.player < 0 || rec.player > MAXPLAYERS)
+    {
+	I_Error ("P_UnArchiveMobj: bad mobj in savegame");
+    }
+
+    mobj = P_AllocMobj ();
+    memset (mobj, 0, sizeof(*mobj));
+
+    mobj->x = rec.x;
+    mobj->y = rec.y;
+    mobj->z = rec.z;
+    mobj->angle = rec.angle;
+    mobj->sprite = rec.sprite;
+    mobj->frame = rec.frame;
+    mobj->radius = rec.radius;
+    mobj->height = rec.height;
+    mobj->momx = rec.momx;
+    mobj->momy = rec.momy;
+    mobj->momz = rec.momz;
+    mobj->type = rec.type;
+    mobj->tics = rec.tics;
+    mobj->state = &states[rec.state];
+    mobj->flags = rec.flags;
+    mobj->health = rec.health;
+    mobj->movedir = rec.movedir;
+    mobj->movecount = rec.movecount;
+    mobj->reactiontime = rec.reactiontime;
+    mobj->threshold = rec.threshold;
+    mobj->lastlook = rec.lastlook;
+    mobj->spawnpoint = rec.spawnpoint;
+
+    if (rec.player)
+    {
+	mobj->player = &players[rec.player - 1];
+	mobj->player->mo = mobj;
+    }
+
+    mobj->subsector = R_PointInSubsector (mobj->x, mobj->y);
+    mobj->info = &mobjinfo[mobj->type];
+
+    // the heights P_CheckPosition found, which can differ
+    // from those of the sector the mobj is in
+    mobj->floorz = rec.floorz;
+    mobj->ceilingz = rec.ceilingz;
+
+    mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
+    P_AddThinker (&mobj->thinker);
+    P_ResetInterpolation (mobj);
+
+    refs[0] = rec.target;
+    refs[1] = rec.tracer;
+    links[0] = rec.sectororder;
+    links[1] = rec.blockorder;
+
+    return mobj;
+}
+
+//
+// P_ArchiveThinkersFast
+// Mobjs and specials in one list, in thinker order.
+//
+static void P_ArchiveThinkersFast (void)
+{
+    thinker_t*	th;
+
+    saveg_write32(numsavemobjs);
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	{
+	    saveg_write8(tc_fastmobj);
+	    P_ArchiveMobj ((mobj_t *) th);
+	    continue;
 	}
-	
+
+	P_ArchiveSpecial (th, true);
+    }
+
+    saveg_write8(tc_endspecials);
+}
+
+//
+// P_SortLinks
+// Puts the indices of the mobjs linked into a sector (which 0)
+// or block (which 1) into sorted, in order of their place there.
+// Returns how many there are.
+//
+static int P_SortLinks (int which, int* sorted)
+{
+    int*	counts;
+    int		order;
+    int		total;
+    int		i;
+
+    counts = Z_Malloc ((numsavemobjs + 1) * sizeof(*counts), PU_STATIC, NULL);
+
+    for (i=0 ; i<=numsavemobjs ; i++)
+	counts[i] = 0;
+
+    for (i=0 ; i<numsavemobjs ; i++)
+    {
+	order = savelinks[i*2+which];
+
+	if (order >= numsavemobjs)
+	    I_Error ("P_SortLinks: bad link %i in savegame", order);
+
+	if (order >= 0)
+	    counts[order+1]++;
     }
 
+    for (i=1 ; i<=numsavemobjs ; i++)
+	counts[i] += counts[i-1];
+
+    total = counts[numsavemobjs];
+
+    for (i=0 ; i<numsavemobjs ; i++)
+    {
+	order = savelinks[i*2+which];
+
+	if (order >= 0)
+	    sorted[counts[order]++] = i;
+    }
+
+    Z_Free (counts);
+
+    return total;
 }
 
+//
+// P_LinkMobjs
+// Links the loaded mobjs into the sectors and blocks in the
+// order they were in.  A sector list is built from its tail;
+// a block is filled from its start.
+//
+static void P_LinkMobjs (void)
+{
+    int*	sorted;
+    int		count;
+    int		i;
+
+    sorted = Z_Malloc (numsavemobjs * sizeof(*sorted) + 1, PU_STATIC, NULL);
+
+    count = P_SortLinks (0, sorted);
+
+    for (i=count-1 ; i>=0 ; i--)
+	P_LinkThingToSector (savemobjs[sorted[i]]);
+
+    count = P_SortLinks (1, sorted);
+
+    for (i=0 ; i<count ; i++)
+	P_LinkThingToBlock (savemobjs[sorted[i]]);
+
+    Z_Free (sorted);
+}
+
+//
+// P_UnArchiveThinkersFast
+//
+static void P_UnArchiveThinkersFast (void)
+{
+    int*	refs;
+    int		count;
+    byte	tclass;
+    int		i;
+
+    P_RemoveAllThinkers ();
+
+    for (i = 0; i < MAXCEILINGS; i++)
+	activeceilings[i] = NULL;
+
+    for (i = 0; i < MAXPLATS; i++)
+	activeplats[i] = NULL;
+
+    count = saveg_read32();
+
+    if (count < 0 || savegame_error)
+	I_Error ("P_UnArchiveThinkersFast: bad mobj count %i", count);
+
+    savemobjs = Z_Malloc (count * sizeof(*savemobjs) + 1, PU_STATIC, NULL);
+    savelinks = Z_Malloc (count * 2 * sizeof(*savelinks) + 1,
+			  PU_STATIC, NULL);
+    refs = Z_Malloc (count * 2 * sizeof(*refs) + 1, PU_STATIC, NULL);
+    numsavemobjs = 0;
+
+    while (1)
+    {
+	tclass = saveg_read8();
+
+	if (tclass != tc_fastmobj)
+	{
+	    if (!P_UnArchiveSpecial (tclass))
+		break;
+	    continue;
+	}
+
+	if (numsavemobjs == count)
+	    I_Error ("P_UnArchiveThinkersFast: too many mobjs in savegame");
+
+	savemobjs[numsavemobjs] =
+	    P_UnArchiveMobj (&refs[numsavemobjs*2],
+			     &savelinks[numsavemobjs*2]);
+	numsavemobjs++;
+    }
+
+    // now that every mobj exists, point them at each other
+    for (i=0 ; i<numsavemobjs ; i++)
+    {
+	savemobjs[i]->target = P_LoadedMobj (refs[i*2]);
+	savemobjs[i]->tracer = P_LoadedMobj (refs[i*2+1]);
+    }
+
+    Z_Free (refs);
+
+    P_LinkMobjs ();
+}
+
+//
+// P_ArchiveReferences
+// What else points at mobjs: player attackers, the sound
+// targets of sectors, the boss brain's targets and the queue of
+// player corpses.  Then the item respawn queue and the switches
+// waiting to pop back.
+//
+static void P_ArchiveReferences (void)
+{
+    sector_t*	sec;
+    button_t*	button;
+    int		count;
+    int		i;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (playeringame[i])
+	    saveg_write32(P_SavedMobjIndex (players[i].attacker));
+    }
+
+    count = 0;
+
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	if (P_SavedMobjIndex (sec->soundtarget))
+	    count++;
+    }
+
+    saveg_write32(count);
+
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	if (!P_SavedMobjIndex (sec->soundtarget))
+	    continue;
+
+	saveg_write32(i);
+	saveg_write32(P_SavedMobjIndex (sec->soundtarget));
+    }
+
+    saveg_write32(numbraintargets);
+    saveg_write32(braintargeton);
+    saveg_write32(braineasy);
+
+    for (i=0 ; i<numbraintargets ; i++)
+	saveg_write32(P_SavedMobjIndex (braintargets[i]));
+
+    saveg_write32(bodyqueslot);
+
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	saveg_write32(P_SavedMobjIndex (bodyque[i]));
+
+    saveg_write32(iquehead);
+    saveg_write32(iquetail);
+
+    for (i = iquetail ; i != iquehead ; i = (i+1)&(ITEMQUESIZE-1))
+    {
+	saveg_write_block(&itemrespawnque[i], sizeof(mapthing_t));
+	saveg_write32(itemrespawntime[i]);
+    }
+
+    count = 0;
+
+    for (i=0 ; i<MAXBUTTONS ; i++)
+    {
+	if (buttonlist[i].btimer)
+	    count++;
+    }
+
+    saveg_write32(count);
+
+    for (i=0, button = buttonlist ; i<MAXBUTTONS ; i++,button++)
+    {
+	if (!button->btimer)
+	    continue;
+
+	saveg_write32(i);
+	saveg_write32(button->line - lines);
+	saveg_write32(button->where);
+	saveg_write32(button->btexture);
+	saveg_write32(button->btimer);
+    }
+}
+
+//
+// P_UnArchiveReferences
+//
+static void P_UnArchiveReferences (void)
+{
+    button_t*	button;
+    int		count;
+    int		sector;
+    int		line;
+    int		i;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (playeringame[i])
+	    players[i].attacker = P_LoadedMobj (saveg_read32());
+    }
+
+    count = saveg_read32();
+
+    while (count-- > 0 && !savegame_error)
+    {
+	sector = saveg_read32();
+
+	if (sector < 0 || sector >= numsectors)
+	    I_Error ("P_UnArchiveReferences: bad sector %i", sector);
+
+	sectors[sector].soundtarget = P_LoadedMobj (saveg_read32());
+    }
+
+    // the old targets were freed along with the old mobjs
+    numbraintargets = saveg_read32();
+    braintargeton = saveg_read32();
+    braineasy = saveg_read32();
+
+    if (numbraintargets < 0 || numbraintargets > arrlen(braintargets))
+	I_Error ("P_UnArchiveReferences: %i brain targets", numbraintargets);
+
+    for (i=0 ; i<numbraintargets ; i++)
+	braintargets[i] = P_LoadedMobj (saveg_read32());
+
+    // G_CheckSpot removes the oldest corpse once the queue is
+    // full, so it must not point at a freed mobj
+    bodyqueslot = saveg_read32();
+
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	bodyque[i] = P_LoadedMobj (saveg_read32());
+
+    iquehead = saveg_read32() & (ITEMQUESIZE-1);
+    iquetail = saveg_read32() & (ITEMQUESIZE-1);
+
+    for (i = iquetail ; i != iquehead ; i = (i+1)&(ITEMQUESIZE-1))
+    {
+	saveg_read_block(&itemrespawnque[i], sizeof(mapthing_t));
+	itemrespawntime[i] = saveg_read32();
+    }
+
+    // a switch pressed since would never pop back, and one
+    // left over would change its texture at the wrong time
+    memset (buttonlist, 0, sizeof(buttonlist));
+
+    count = saveg_read32();
+
+    while (count-- > 0 && !savegame_error)
+    {
+	i = saveg_read32();
+	line = saveg_read32();
+
+	if (i < 0 || i >= MAXBUTTONS || line < 0 || line >= numlines)
+	    I_Error ("P_UnArchiveReferences: bad button %i on line %i",
+		     i, line);
+
+	button = &buttonlist[i];
+	button->line = &lines[line];
+	button->where = saveg_read32();
+	button->btexture = saveg_read32();
+	button->btimer = saveg_read32();
+	button->soundorg = &button->line->frontsector->soundorg;
+    }
+}
+
+//
+// P_ArchiveGame
+// Writes everything after the header, in the format the header
+// announced.
+//
+void P_ArchiveGame (void)
+{
+    if (!savegame_fast)
+    {
+	P_ArchivePlayers ();
+	P_ArchiveWorld ();
+	P_ArchiveThinkers ();
+	P_ArchiveSpecials ();
+	return;
+    }
+
+    // sleeping lights have to be on the list, with
+    // their countdowns up to date
+    P_WakeThinkers ();
+    P_IndexMobjs ();
+
+    P_ArchivePlayers ();
+    saveg_write32(prndindex);
+    P_ArchiveWorldDelta ();
+    P_ArchiveThinkersFast ();
+    P_ArchiveReferences ();
+
+    P_FreeMobjIndex ();
+}
+
+//
+// P_UnArchiveGame
+//
+void P_UnArchiveGame (void)
+{
+    if (!savegame_fast)
+    {
+	P_UnArchivePlayers ();
+	P_UnArchiveWorld ();
+	P_UnArchiveThinkers ();
+	P_UnArchiveSpecials ();
+	return;
+    }
+
+    P_UnArchivePlayers ();
+    prndindex = saveg_read32() & 0xff;
+    P_UnArchiveWorldDelta ();
+    P_UnArchiveThinkersFast ();
+    P_UnArchiveReferences ();
+
+    P_FreeMobjIndex ();
+}
+
+//
+// P_ArchiveSnapshot
+// The level in the fast format, without a savegame header, for
+// the rewind buffer.
+//
+void P_ArchiveSnapshot (void)
+{
+    savegame_fast = true;
+    saveg_write32(leveltime);
+    P_ArchiveGame ();
+}
+
+//
+// P_UnArchiveSnapshot
+//
+void P_UnArchiveSnapshot (void)
+{
+    savegame_fast = true;
+    leveltime = saveg_read32();
+    P_UnArchiveGame ();
+}
@@ -34,6 +34,25 @@ char *P_TempSaveGameFile(void);
 
 char *P_SaveGameFile(int slot);
 
+// Savegame slots in reserved memory, used instead of files
+// when the board has a window for them.
+
+#define NUMSAVESLOTS 6
+
+boolean P_SaveSlotsAvailable(void);
+boolean P_ReadSaveSlotDescription(int slot, char *description);
+boolean P_OpenSaveSlot(int slot);
+boolean P_CreateSaveSlot(void);
+void P_CommitSaveSlot(int slot);
+
+// The same for any buffer in memory, such as the rewind buffer's.
+void P_OpenSaveBuffer(byte *buffer, int capacity);
+void P_CloseSaveBuffer(void);
+
+// Bytes read or written so far, in a file or a slot.
+
+long P_SaveGamePosition(void);
+
 // Savegame file header read/write functions
 
 boolean P_ReadSaveGameHeader(void);
@@ -55,6 +74,21 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
+// Everything after the header, in the format it names.
+void P_ArchiveGame (void);
+void P_UnArchiveGame (void);
+
+// Keeps the freshly set up level for the fast format.
+void P_SnapshotWorld (void);
+
+// The level alone in the fast format, with no header or
+// trailer, for the rewind buffer.
+void P_ArchiveSnapshot (void);
+void P_UnArchiveSnapshot (void);
+
+// Write new savegames in the fast format rather than vanilla's.
+extern int fast_savegames;
+
 extern FILE *save_stream;
 extern boolean savegame_error;
 
@@ -35,6 +35,7 @@
 
 #include "doomdef.h"
 #include "p_local.h"
+#include "p_saveg.h"
 
 #include "s_sound.h"
 
@@ -69,6 +70,20 @@ line_t*		lines;
 int		numsides;
 side_t*		sides;
 
+// Packed copies of the seg and line fields read in the
+// hottest loops, built by P_PackGeometry.
+int		(*segvertexnums)[2];
+int*		seglinenums;
+vertexpair_t*	linevertexes;
+linegeom_t*	linegeoms;
+fixed_t		(*linebboxes)[4];
+int*		linevalidcount;
+
+// R_PointToAngle of each vertex, valid while the
+// stamp matches framecount.
+angle_t*	vertexangles;
+int*		vertexanglestamps;
+
 static int      totallines;
 
 // BLOCKMAP
@@ -87,8 +102,11 @@ short*		blockmaplump;
 // origin of block map
 fixed_t		bmaporgx;
 fixed_t		bmaporgy;
-// for thing chains
-mobj_t**	blocklinks;		
+// packed line lists, one per block
+int*		blocklineofs;
+blockline_t*	blocklines;
+// things in each block
+blockthings_t*	blockthings;
 
 
 // REJECT
@@ -286,6 +304,7 @@ void P_LoadSectors (int lump)
 	ss->special = SHORT(ms->special);
 	ss->tag = SHORT(ms->tag);
 	ss->thinglist = NULL;
+	ss->interptic = -1;
     }
 	
     W_ReleaseLumpNum(lump);
@@ -509,17 +528,27 @@ void P_LoadBlockMap (int lump)
 
     lumplen = W_LumpLength(lump);
     count = lumplen / 2;
-	
-    blockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
-    W_ReadLump(lump, blockmaplump);
-    blockmap = blockmaplump + 4;
 
-    // Swap all short integers to native byte ordering.
-  
-    for (i=0; i<count; i++)
+#ifdef SYS_LITTLE_ENDIAN
+    // The lump is already in native byte order, so use it
+    // straight from the mapped WAD instead of copying it.
+    blockmaplump = W_CacheLumpNum(lump, PU_LEVEL);
+
+    if (((size_t) blockmaplump & 1) != 0)
+#endif
     {
-	blockmaplump[i] = SHORT(blockmaplump[i]);
+	blockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
+	W_ReadLump(lump, blockmaplump);
+
+	// Swap all short integers to native byte ordering.
+  
+	for (i=0; i<count; i++)
+	{
+	    blockmaplump[i] = SHORT(blockmaplump[i]);
+	}
     }
+
+    blockmap = blockmaplump + 4;
 		
     // Read the header
 
@@ -530,9 +559,9 @@ void P_LoadBlockMap (int lump)
 	
     // Clear out mobj chains
 
-    count = sizeof(*blocklinks) * bmapwidth * bmapheight;
-    blocklinks = Z_Malloc(count, PU_LEVEL, 0);
-    memset(blocklinks, 0, count);
+    count = sizeof(*blockthings) * bmapwidth * bmapheight;
+    blockthings = Z_Malloc(count, PU_LEVEL, 0);
+    memset(blockthings, 0, count);
 }
 
 
@@ -655,6 +684,132 @@ void P_GroupLines (void)
 	
 }
 
+//
+// P_PackGeometry
+// Builds the packed seg and line arrays from the loaded
+// level data.  R_AddLine, P_CrossSubsector and the
+// blockmap line iterator walk these instead of the
+// full seg_t/line_t records, and the side and intercept
+// tests use the precalculated line geometry.
+//
+void P_PackGeometry (void)
+{
+    int			i;
+    seg_t*		seg;
+    line_t*		li;
+    vertexpair_t*	vp;
+    linegeom_t*		lg;
+
+    segvertexnums = Z_Malloc (numsegs*sizeof(*segvertexnums), PU_LEVEL, 0);
+    seglinenums = Z_Malloc (numsegs*sizeof(*seglinenums), PU_LEVEL, 0);
+
+    seg = segs;
+    for (i=0 ; i<numsegs ; i++, seg++)
+    {
+	segvertexnums[i][0] = seg->v1 - vertexes;
+	segvertexnums[i][1] = seg->v2 - vertexes;
+	seglinenums[i] = seg->linedef - lines;
+    }
+
+    vertexangles = Z_Malloc (numvertexes*sizeof(*vertexangles), PU_LEVEL, 0);
+    vertexanglestamps = Z_Malloc (numvertexes*sizeof(*vertexanglestamps),
+                                  PU_LEVEL, 0);
+    memset (vertexanglestamps, 0, numvertexes*sizeof(*vertexanglestamps));
+
+    linevertexes = Z_Malloc (numlines*sizeof(*linevertexes), PU_LEVEL, 0);
+    linegeoms = Z_Malloc (numlines*sizeof(*linegeoms), PU_LEVEL, 0);
+    linebboxes = Z_Malloc (numlines*sizeof(*linebboxes), PU_LEVEL, 0);
+    linevalidcount = Z_Malloc (numlines*sizeof(*linevalidcount), PU_LEVEL, 0);
+    memset (linevalidcount, 0, numlines*sizeof(*linevalidcount));
+    volleylines = Z_Malloc (numlines*sizeof(*volleylines), PU_LEVEL, 0);
+    memset (volleylines, 0, numlines*sizeof(*volleylines));
+
+    li = lines;
+    vp = linevertexes;
+    lg = linegeoms;
+    for (i=0 ; i<numlines ; i++, li++, vp++, lg++)
+    {
+	vp->x1 = li->v1->x;
+	vp->y1 = li->v1->y;
+	vp->x2 = li->v2->x;
+	vp->y2 = li->v2->y;
+
+	lg->x = li->v1->x;
+	lg->y = li->v1->y;
+	lg->dx = li->dx;
+	lg->dy = li->dy;
+	lg->dxint = li->dx>>FRACBITS;
+	lg->dyint = li->dy>>FRACBITS;
+	lg->dxfrac = li->dx>>8;
+	lg->dyfrac = li->dy>>8;
+	lg->slopetype = li->slopetype;
+
+	linebboxes[i][BOXTOP] = li->bbox[BOXTOP];
+	linebboxes[i][BOXBOTTOM] = li->bbox[BOXBOTTOM];
+	linebboxes[i][BOXLEFT] = li->bbox[BOXLEFT];
+	linebboxes[i][BOXRIGHT] = li->bbox[BOXRIGHT];
+    }
+}
+
+//
+// P_PackBlockmap
+// Copies each block's line list out of the BLOCKMAP lump
+// into one array, with every line's bounding box next to
+// its number, so the line iterators and PIT_CheckLine's
+// box test read contiguous memory.  The lists keep the
+// lump's order, including the leading line 0.
+//
+void P_PackBlockmap (void)
+{
+    int			numblocks;
+    int			count;
+    int			i;
+    short*		list;
+    blockline_t*	bl;
+
+    numblocks = bmapwidth * bmapheight;
+    count = 0;
+
+    for (i=0 ; i<numblocks ; i++)
+    {
+	list = blockmaplump + (unsigned short) blockmap[i];
+
+	for ( ; *list != -1 ; list++)
+	{
+	    if ((unsigned) *list >= (unsigned) numlines)
+		I_Error ("P_PackBlockmap: bad line %i in block %i",
+			 *list, i);
+	    count++;
+	}
+
+	count++;
+    }
+
+    blocklineofs = Z_Malloc (numblocks*sizeof(*blocklineofs), PU_LEVEL, 0);
+    blocklines = Z_Malloc (count*sizeof(*blocklines), PU_LEVEL, 0);
+
+    bl = blocklines;
+
+    for (i=0 ; i<numblocks ; i++)
+    {
+	blocklineofs[i] = bl - blocklines;
+
+	for (list = blockmaplump + (unsigned short) blockmap[i] ;
+	     *list != -1 ;
+	     list++, bl++)
+	{
+	    bl->linenum = *list;
+	    bl->bbox[BOXTOP] = linebboxes[*list][BOXTOP];
+	    bl->bbox[BOXBOTTOM] = linebboxes[*list][BOXBOTTOM];
+	    bl->bbox[BOXLEFT] = linebboxes[*list][BOXLEFT];
+	    bl->bbox[BOXRIGHT] = linebboxes[*list][BOXRIGHT];
+	}
+
+	bl->linenum = -1;
+	bl++;
+    }
+}
+
 // Pad the REJECT lump with extra data when the lump is too small,
 // to simulate a REJECT buffer overflow in Vanilla Doom.
 
@@ -709,6 +864,18 @@ static void PadRejectArray(byte *array, unsigned int len)
     }
 }
 
+//
+// P_LoadReject
+// An empty REJECT lump is used as it is.  Filling one in from
+// sector connectivity would have to reject only pairs that
+// P_CheckSight's BSP walk cannot see across, and that cannot be
+// shown: P_DivlineSide drops the fraction of every coordinate,
+// and for horizontal lines compares x against the line's y, so
+// sight lines near corners or along partitions pass walls that
+// connectivity says must block them.  Sectors moved without a
+// line special (tags 666 and 667) and maps whose sectors do not
+// close make it worse.
+//
 static void P_LoadReject(int lumpnum)
 {
     int minlength;
@@ -804,6 +971,8 @@ P_SetupLevel
     P_LoadSegs (lumpnum+ML_SEGS);
 
     P_GroupLines ();
+    P_PackGeometry ();
+    P_PackBlockmap ();
     P_LoadReject (lumpnum+ML_REJECT);
 
     bodyqueslot = 0;
@@ -827,10 +996,16 @@ P_SetupLevel
 	
     // set up world state
     P_SpawnSpecials ();
+
+    // keep it for fast savegames to compare against
+    P_SnapshotWorld ();
 	
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
+    // drop lookups for textures this level does not use
+    R_FlushTextureLookups ();
+
     // preload graphics
     if (precache)
 	R_PrecacheLevel ();
@@ -21,6 +21,7 @@
 #include "doomdef.h"
 
 #include "i_system.h"
+#include "i_timer.h"
 #include "p_local.h"
 
 // State.
@@ -39,6 +40,48 @@ fixed_t		t2y;
 
 int		sightcounts[2];
 
+#ifdef CYCLEPROFILE
+// cycles spent walking the BSP for sight checks
+uint64_t	sightcycles;
+#endif
+
+//
+// Sight cache.
+// The result of a sight check depends only on where the two
+// things are and on the sector heights, so it is kept per
+// pair of things along with their positions.  Any change to
+// a floor or ceiling starts a new epoch, which drops every
+// entry.  The cache is direct mapped; a colliding pair just
+// replaces the old entry.
+//
+#define SIGHTCACHESIZE	512
+
+typedef struct
+{
+    mobj_t*	t1;
+    mobj_t*	t2;
+    fixed_t	x1, y1, z1, height1;
+    fixed_t	x2, y2, z2, height2;
+    int		epoch;
+    boolean	result;
+} sightcache_t;
+
+static sightcache_t	sightcache[SIGHTCACHESIZE];
+static int		sightepoch = 1;
+
+int		sightcachehits;
+int		sightcachemisses;
+
+
+//
+// P_InvalidateSightCache
+// Called whenever sector heights change.
+//
+void P_InvalidateSightCache (void)
+{
+    sightepoch++;
+}
+
 
 //
 // P_DivlineSide
@@ -138,8 +181,9 @@ boolean P_CrossSubsector (int num)
     fixed_t		opentop;
     fixed_t		openbottom;
     divline_t		divl;
-    vertex_t*		v1;
-    vertex_t*		v2;
+    vertexpair_t*	vp;
+    int			linenum;
+    int			segnum;
     fixed_t		frac;
     fixed_t		slope;
 	
@@ -154,31 +198,32 @@ boolean P_CrossSubsector (int num)
     
     // check lines
     count = sub->numlines;
-    seg = &segs[sub->firstline];
+    segnum = sub->firstline;
 
-    for ( ; count ; seg++, count--)
+    // Only the packed line arrays are touched until
+    // a line is known to be crossed.
+    for ( ; count ; segnum++, count--)
     {
-	line = seg->linedef;
+	linenum = seglinenums[segnum];
 
 	// allready checked other side?
-	if (line->validcount == validcount)
+	if (linevalidcount[linenum] == validcount)
 	    continue;
 	
-	line->validcount = validcount;
+	linevalidcount[linenum] = validcount;
 
-	v1 = line->v1;
-	v2 = line->v2;
-	s1 = P_DivlineSide (v1->x,v1->y, &strace);
-	s2 = P_DivlineSide (v2->x, v2->y, &strace);
+	vp = &linevertexes[linenum];
+	s1 = P_DivlineSide (vp->x1, vp->y1, &strace);
+	s2 = P_DivlineSide (vp->x2, vp->y2, &strace);
 
 	// line isn't crossed?
 	if (s1 == s2)
 	    continue;
 	
-	divl.x = v1->x;
-	divl.y = v1->y;
-	divl.dx = v2->x - v1->x;
-	divl.dy = v2->y - v1->y;
+	divl.x = vp->x1;
+	divl.y = vp->y1;
+	divl.dx = vp->x2 - vp->x1;
+	divl.dy = vp->y2 - vp->y1;
 	s1 = P_DivlineSide (strace.x, strace.y, &divl);
 	s2 = P_DivlineSide (t2x, t2y, &divl);
 
@@ -186,6 +231,9 @@ boolean P_CrossSubsector (int num)
 	if (s1 == s2)
 	    continue;	
 
+	seg = &segs[segnum];
+	line = &lines[linenum];
+
         // Backsector may be NULL if this is an "impassible
         // glass" hack line.
 
@@ -307,6 +355,11 @@ P_CheckSight
     int		pnum;
     int		bytenum;
     int		bitnum;
+#ifdef CYCLEPROFILE
+    uint64_t	start;
+#endif
+    boolean	result;
+    sightcache_t*	entry;
     
     // First check for trivial rejection.
 
@@ -330,6 +383,22 @@ P_CheckSight
     // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
+    entry = &sightcache[(((size_t) t1 >> 4) ^ ((size_t) t2 >> 2))
+			& (SIGHTCACHESIZE-1)];
+
+    if (entry->epoch == sightepoch
+	&& entry->t1 == t1 && entry->t2 == t2
+	&& entry->x1 == t1->x && entry->y1 == t1->y
+	&& entry->z1 == t1->z && entry->height1 == t1->height
+	&& entry->x2 == t2->x && entry->y2 == t2->y
+	&& entry->z2 == t2->z && entry->height2 == t2->height)
+    {
+	sightcachehits++;
+	return entry->result;
+    }
+
+    sightcachemisses++;
+
     validcount++;
 	
     sightzstart = t1->z + t1->height - (t1->height>>2);
@@ -344,7 +413,28 @@ P_CheckSight
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+#ifdef CYCLEPROFILE
+    start = I_GetCycles ();
+    result = P_CrossBSPNode (numnodes-1);
+    sightcycles += I_GetCycles () - start;
+#else
+    result = P_CrossBSPNode (numnodes-1);
+#endif
+
+    entry->t1 = t1;
+    entry->t2 = t2;
+    entry->x1 = t1->x;
+    entry->y1 = t1->y;
+    entry->z1 = t1->z;
+    entry->height1 = t1->height;
+    entry->x2 = t2->x;
+    entry->y2 = t2->y;
+    entry->z2 = t2->z;
+    entry->height2 = t2->height;
+    entry->epoch = sightepoch;
+    entry->result = result;
+
+    return result;
 }
 
 
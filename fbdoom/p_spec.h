@@ -125,6 +125,7 @@ typedef struct
     int		count;
     int		maxlight;
     int		minlight;
+    sleeper_t	sleeper;	// while counting down
     
 } fireflicker_t;
 
@@ -139,6 +140,7 @@ typedef struct
     int		minlight;
     int		maxtime;
     int		mintime;
+    sleeper_t	sleeper;	// while counting down
     
 } lightflash_t;
 
@@ -153,6 +155,7 @@ typedef struct
     int		maxlight;
     int		darktime;
     int		brighttime;
+    sleeper_t	sleeper;	// while counting down
     
 } strobe_t;
 
@@ -175,6 +178,7 @@ typedef struct
 #define FASTDARK			15
 #define SLOWDARK			35
 
+void    T_FireFlicker (fireflicker_t* flick);
 void    P_SpawnFireFlicker (sector_t* sector);
 void    T_LightFlash (lightflash_t* flash);
 void    P_SpawnLightFlash (sector_t* sector);
@@ -124,6 +124,9 @@ EV_Teleport
 
 		thing->angle = m->angle;
 		thing->momx = thing->momy = thing->momz = 0;
+
+		// don't slide the view through the teleport
+		P_ResetInterpolation (thing);
 		return 1;
 	    }	
 	}
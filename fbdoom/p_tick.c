@@ -18,8 +18,14 @@
 //
 
 
+#include "string.h"
+
 #include "z_zone.h"
+#include "d_loop.h"
+#include "i_system.h"
+#include "m_random.h"
 #include "p_local.h"
+#include "p_tick.h"
 
 #include "doomstat.h"
 
@@ -39,6 +45,62 @@ int	leveltime;
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+// Mobjs are carved out of PU_LEVEL chunks rather than
+// allocated one by one, so that the mobjs P_RunThinkers
+// visits in turn are close together in memory.  The list
+// itself keeps the vanilla order, which demo sync needs.
+#define MOBJCHUNK	128
+
+typedef struct mobjchunk_s
+{
+    struct mobjchunk_s*	next;
+    mobj_t		mobjs[MOBJCHUNK];
+} mobjchunk_t;
+
+static mobjchunk_t*	mobjchunks;
+
+// Free mobjs, linked through thinker.next.
+static mobj_t*		freemobjs;
+
+// Thinkers unlinked by P_RunThinkers this tic.  They are
+// freed by P_Ticker once every thinker has run, so nothing
+// touches freed memory during the tic.  Linked through
+// prev; next is left alone for anyone still walking.
+static thinker_t*	removedthinkers;
+
+// Thinkers asleep, in the timer wheel slot of the leveltime
+// they wake at.  A light spends most tics counting down to its
+// next change; asleep, it is not visited until the last one.
+#define SLEEPSLOTS	64
+
+static sleeper_t*	sleepers[SLEEPSLOTS];
+
+// Sleepers due this tic, in list order, and the one the
+// running thinker has just put to sleep.
+static sleeper_t*	wokensleepers;
+static sleeper_t*	fallingasleep;
+
+static int		thinkerseq;
+
+// Per tic scratch memory, for buffers such as the intercepts
+// and spechit lists that only need to live for one tic.  When
+// a block fills up a bigger one is started; the old ones are
+// kept until the next tic, since callers may still hold them.
+#define TICARENASIZE	(16*1024)
+
+typedef struct ticblock_s
+{
+    struct ticblock_s*	prev;
+    int			size;
+    int			used;
+} ticblock_t;
+
+static ticblock_t*	ticarena;
+
+// Bumped whenever the arena is reset.  Users compare it with
+// the epoch they allocated in to tell if they must start over.
+int			ticarenaepoch;
+
 
 //
 // P_InitThinkers
@@ -46,6 +108,17 @@ thinker_t	thinkercap;
 void P_InitThinkers (void)
 {
     thinkercap.prev = thinkercap.next  = &thinkercap;
+
+    // The chunks are PU_LEVEL and go with the level.
+    mobjchunks = NULL;
+    freemobjs = NULL;
+    removedthinkers = NULL;
+
+    // The sleepers are part of their thinkers.
+    memset (sleepers, 0, sizeof(sleepers));
+    wokensleepers = NULL;
+    fallingasleep = NULL;
+    thinkerseq = 0;
 }
 
 
@@ -60,6 +133,7 @@ void P_AddThinker (thinker_t* thinker)
     thinkercap.prev->next = thinker;
     thinker->next = &thinkercap;
     thinker->prev = thinkercap.prev;
+    thinker->seq = thinkerseq++;
     thinkercap.prev = thinker;
 }
 
@@ -78,6 +152,103 @@ void P_RemoveThinker (thinker_t* thinker)
 
 
 
+//
+// P_SleepThinker
+// Called by a running thinker that has just set *count and
+// will do nothing but count it down until it reaches zero.
+// It is taken off the list, and linked back in where it was
+// on the tic the count would have reached one.  Until then
+// *count is stale; P_WakeThinkers brings it up to date.
+//
+void
+P_SleepThinker
+( thinker_t*	thinker,
+  sleeper_t*	sleeper,
+  int*		count )
+{
+    if (*count < 2)
+	return;
+
+    sleeper->thinker = thinker;
+    sleeper->count = count;
+    sleeper->wake = leveltime + *count;
+    fallingasleep = sleeper;
+}
+
+
+//
+// P_InsertSleeper
+// Adds a sleeper to a list kept in thinker order.
+//
+static void P_InsertSleeper (sleeper_t** list, sleeper_t* sleeper)
+{
+    while (*list && (*list)->thinker->seq < sleeper->thinker->seq)
+	list = &(*list)->next;
+
+    sleeper->next = *list;
+    *list = sleeper;
+}
+
+
+//
+// P_LinkSleeper
+// Links a sleeper's thinker back in before another,
+// with its countdown brought up to date.
+//
+static void P_LinkSleeper (sleeper_t* sleeper, thinker_t* before)
+{
+    thinker_t*	thinker;
+
+    thinker = sleeper->thinker;
+    *sleeper->count = sleeper->wake - leveltime + 1;
+
+    thinker->next = before;
+    thinker->prev = before->prev;
+    before->prev->next = thinker;
+    before->prev = thinker;
+}
+
+
+//
+// P_WakeThinkers
+// Links every sleeping thinker back in, for anything
+// that walks the whole list.
+//
+void P_WakeThinkers (void)
+{
+    sleeper_t*	woken;
+    sleeper_t*	sleeper;
+    thinker_t*	th;
+    int		i;
+
+    woken = NULL;
+
+    for (i=0 ; i<SLEEPSLOTS ; i++)
+    {
+	while (sleepers[i])
+	{
+	    sleeper = sleepers[i];
+	    sleepers[i] = sleeper->next;
+	    P_InsertSleeper (&woken, sleeper);
+	}
+    }
+
+    th = thinkercap.next;
+
+    while (woken)
+    {
+	sleeper = woken;
+	woken = sleeper->next;
+
+	while (th != &thinkercap && th->seq < sleeper->thinker->seq)
+	    th = th->next;
+
+	P_LinkSleeper (sleeper, th);
+    }
+}
+
+
+
 //
 // P_AllocateThinker
 // Allocates memory and adds a new thinker at the end of the list.
@@ -88,27 +259,147 @@ void P_AllocateThinker (thinker_t*	thinker)
 
 
 
+//
+// P_AllocMobj
+// Returns an uninitialised mobj from the level's mobj chunks.
+//
+mobj_t* P_AllocMobj (void)
+{
+    mobjchunk_t*	chunk;
+    mobj_t*		mobj;
+    int			i;
+
+    if (!freemobjs)
+    {
+	chunk = Z_Malloc (sizeof(*chunk), PU_LEVEL, NULL);
+	chunk->next = mobjchunks;
+	mobjchunks = chunk;
+
+	// Hand them out in address order.
+	for (i=MOBJCHUNK-1 ; i>=0 ; i--)
+	{
+	    chunk->mobjs[i].thinker.next = (thinker_t *) freemobjs;
+	    freemobjs = &chunk->mobjs[i];
+	}
+    }
+
+    mobj = freemobjs;
+    freemobjs = (mobj_t *) mobj->thinker.next;
+
+#ifdef ZONE_DEBUG
+    Z_Poison (&mobj->thinker.next, sizeof(mobj->thinker.next));
+
+    if (!Z_CheckPoison (mobj, sizeof(*mobj)))
+	I_Error ("P_AllocMobj: mobj written after it was freed");
+#endif
+
+    return mobj;
+}
+
+
+
+//
+// P_FreeThinker
+// Releases a thinker that has been unlinked from the list.
+//
+static void P_FreeThinker (thinker_t* thinker)
+{
+    mobjchunk_t*	chunk;
+    mobj_t*		mobj;
+
+    mobj = (mobj_t *) thinker;
+
+    for (chunk = mobjchunks ; chunk ; chunk = chunk->next)
+    {
+	if (mobj >= chunk->mobjs && mobj < chunk->mobjs + MOBJCHUNK)
+	{
+#ifdef ZONE_DEBUG
+	    Z_Poison (mobj, sizeof(*mobj));
+#endif
+	    thinker->next = (thinker_t *) freemobjs;
+	    freemobjs = mobj;
+	    return;
+	}
+    }
+
+    Z_Free (thinker);
+}
+
+
+
 //
 // P_RunThinkers
 //
 void P_RunThinkers (void)
 {
     thinker_t*	currentthinker;
+    sleeper_t**	slot;
+    sleeper_t*	sleeper;
+
+    // take out the sleepers due this tic
+    slot = &sleepers[leveltime & (SLEEPSLOTS-1)];
+
+    while (*slot)
+    {
+	sleeper = *slot;
+
+	if (sleeper->wake != leveltime)
+	{
+	    slot = &sleeper->next;
+	    continue;
+	}
+
+	*slot = sleeper->next;
+	P_InsertSleeper (&wokensleepers, sleeper);
+    }
 
     currentthinker = thinkercap.next;
-    while (currentthinker != &thinkercap)
+    for (;;)
     {
-	if ( currentthinker->function.acv == (actionf_v)(-1) )
+	// link due sleepers back in where they were, and
+	// run them in their turn
+	if (wokensleepers
+	    && (currentthinker == &thinkercap
+		|| wokensleepers->thinker->seq < currentthinker->seq))
+	{
+	    sleeper = wokensleepers;
+	    wokensleepers = sleeper->next;
+	    P_LinkSleeper (sleeper, currentthinker);
+	    currentthinker = sleeper->thinker;
+	}
+	else if (currentthinker == &thinkercap)
+	    break;
+
+	if (currentthinker->function.acp1 == (actionf_p1) P_MobjThinker)
 	{
-	    // time to remove it
+	    // most thinkers are mobjs; a direct call
+	    // is cheaper than going through the pointer
+	    P_MobjThinker ((mobj_t *) currentthinker);
+	}
+	else if ( currentthinker->function.acv == (actionf_v)(-1) )
+	{
+	    // time to remove it; freed at the end of the tic
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free (currentthinker);
+	    currentthinker->prev = removedthinkers;
+	    removedthinkers = currentthinker;
 	}
 	else
 	{
 	    if (currentthinker->function.acp1)
 		currentthinker->function.acp1 (currentthinker);
+
+	    if (fallingasleep)
+	    {
+		// off the list; next is left for us to follow
+		currentthinker->next->prev = currentthinker->prev;
+		currentthinker->prev->next = currentthinker->next;
+
+		slot = &sleepers[fallingasleep->wake & (SLEEPSLOTS-1)];
+		fallingasleep->next = *slot;
+		*slot = fallingasleep;
+		fallingasleep = NULL;
+	    }
 	}
 	currentthinker = currentthinker->next;
     }
@@ -116,6 +407,158 @@ void P_RunThinkers (void)
 
 
 
+//
+// P_FreeRemovedThinkers
+//
+static void P_FreeRemovedThinkers (void)
+{
+    thinker_t*	thinker;
+
+    while (removedthinkers)
+    {
+	thinker = removedthinkers;
+	removedthinkers = thinker->prev;
+	P_FreeThinker (thinker);
+    }
+}
+
+
+
+//
+// P_ClearThinkers
+// Empties the thinker list once every thinker on it has been
+// removed or freed, as when a savegame is loaded over the
+// level.  The level's mobj chunks are kept and reused, so a
+// level loaded over again and again does not grow.
+//
+void P_ClearThinkers (void)
+{
+    mobjchunk_t*	chunk;
+    int			i;
+
+    P_FreeRemovedThinkers ();
+
+    thinkercap.prev = thinkercap.next  = &thinkercap;
+    freemobjs = NULL;
+
+    for (chunk = mobjchunks ; chunk ; chunk = chunk->next)
+    {
+	for (i=MOBJCHUNK-1 ; i>=0 ; i--)
+	{
+#ifdef ZONE_DEBUG
+	    Z_Poison (&chunk->mobjs[i], sizeof(mobj_t));
+#endif
+	    chunk->mobjs[i].thinker.next = (thinker_t *) freemobjs;
+	    freemobjs = &chunk->mobjs[i];
+	}
+    }
+
+    memset (sleepers, 0, sizeof(sleepers));
+    wokensleepers = NULL;
+    fallingasleep = NULL;
+    thinkerseq = 0;
+}
+
+
+//
+// P_TicAlloc
+// Returns size bytes of scratch memory, valid until the
+// start of the next tic.
+//
+void* P_TicAlloc (int size)
+{
+    ticblock_t*	block;
+    int		blocksize;
+    byte*	result;
+
+    size = (size + 7) & ~7;
+
+    if (!ticarena || ticarena->used + size > ticarena->size)
+    {
+	blocksize = ticarena ? ticarena->size * 2 : TICARENASIZE;
+
+	while (blocksize < size)
+	    blocksize *= 2;
+
+	block = Z_Malloc (sizeof(*block) + blocksize, PU_STATIC, NULL);
+	block->prev = ticarena;
+	block->size = blocksize;
+	block->used = 0;
+	ticarena = block;
+    }
+
+    result = (byte *) (ticarena + 1) + ticarena->used;
+    ticarena->used += size;
+
+    return result;
+}
+
+
+//
+// P_ResetTicArena
+// Frees all but the newest (biggest) block, so that the
+// arena settles at the size a busy tic needs.
+//
+static void P_ResetTicArena (void)
+{
+    ticblock_t*	block;
+
+    if (ticarena)
+    {
+	while (ticarena->prev)
+	{
+	    block = ticarena->prev;
+	    ticarena->prev = block->prev;
+	    Z_Free (block);
+	}
+
+	ticarena->used = 0;
+    }
+
+    ticarenaepoch++;
+}
+
+
+//
+// P_SaveInterpolation
+// Remembers where every thing and player view is before the
+// tic runs, so that frames drawn between tics can place them
+// part way along.  Only the renderer reads the old values.
+//
+static void P_SaveInterpolation (void)
+{
+    thinker_t*	th;
+    mobj_t*	mo;
+    player_t*	player;
+    int		i;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+	if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+	    continue;
+
+	mo = (mobj_t *) th;
+	mo->oldx = mo->x;
+	mo->oldy = mo->y;
+	mo->oldz = mo->z;
+	mo->oldangle = mo->angle;
+    }
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i] || !players[i].mo)
+	    continue;
+
+	// viewz is 1 until the first tic of the level has run
+	player = &players[i];
+	if (player->viewz == 1)
+	    player->oldviewz = player->mo->z + player->viewheight;
+	else
+	    player->oldviewz = player->viewz;
+    }
+}
+
+
 //
 // P_Ticker
 //
@@ -127,6 +570,11 @@ void P_Ticker (void)
     // run the tic
     if (paused)
 	return;
+
+    P_ResetTicArena ();
+
+    // a loaded game or a new level brings new heights
+    P_InvalidateSightCache ();
 		
     // pause if in menu and at least one tic has been run
     if ( !netgame
@@ -136,7 +584,9 @@ void P_Ticker (void)
     {
 	return;
     }
-    
+
+    if (uncapped_framerate)
+	P_SaveInterpolation ();
 		
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
@@ -145,7 +595,77 @@ void P_Ticker (void)
     P_RunThinkers ();
     P_UpdateSpecials ();
     P_RespawnSpecials ();
+    P_FreeRemovedThinkers ();
 
     // for par times
     leveltime++;	
 }
+
+
+
+//
+// P_StateChecksum
+// Hashes the parts of the game state that drift first
+// when a demo or netgame desyncs: player positions,
+// the position and health of every map object in
+// thinker order, sector heights and the play
+// simulation random index.  Netgames check confirmed
+// tics with it, so it must not miss a drift for long.
+//
+#define CHECKSUM_PRIME	16777619u
+
+#define CHECKSUM_ADD(sum, v) \
+    ((sum) = ((sum) ^ (unsigned int) (v)) * CHECKSUM_PRIME)
+
+unsigned int P_StateChecksum (void)
+{
+    unsigned int	sum;
+    thinker_t*		th;
+    mobj_t*		mo;
+    sector_t*		sec;
+    int			nummobjs;
+    int			i;
+
+    sum = 2166136261u;
+
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i] || !players[i].mo)
+	    continue;
+
+	mo = players[i].mo;
+	CHECKSUM_ADD(sum, mo->x);
+	CHECKSUM_ADD(sum, mo->y);
+	CHECKSUM_ADD(sum, mo->z);
+	CHECKSUM_ADD(sum, mo->angle);
+	CHECKSUM_ADD(sum, mo->momx);
+	CHECKSUM_ADD(sum, mo->momy);
+	CHECKSUM_ADD(sum, players[i].health);
+    }
+
+    nummobjs = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+	if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+	    continue;
+
+	mo = (mobj_t *) th;
+	CHECKSUM_ADD(sum, mo->x);
+	CHECKSUM_ADD(sum, mo->y);
+	CHECKSUM_ADD(sum, mo->z);
+	CHECKSUM_ADD(sum, mo->health);
+	nummobjs++;
+    }
+
+    for (i=0, sec = sectors ; i<numsectors ; i++, sec++)
+    {
+	CHECKSUM_ADD(sum, sec->floorheight);
+	CHECKSUM_ADD(sum, sec->ceilingheight);
+    }
+
+    CHECKSUM_ADD(sum, nummobjs);
+    CHECKSUM_ADD(sum, prndindex);
+
+    return sum;
+}
@@ -28,6 +28,9 @@
 // Carries out all thinking of monsters and players.
 void P_Ticker (void);
 
+// Hash of the play simulation state, for desync checks.
+unsigned int P_StateChecksum (void);
+
 
 
 #endif
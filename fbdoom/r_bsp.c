@@ -257,12 +257,17 @@ void R_AddLine (seg_t*	line)
     angle_t		angle2;
     angle_t		span;
     angle_t		tspan;
+    int*		vertnums;
     
     curline = line;
 
+    // Most segs are rejected below on their vertex
+    // angles alone, which are cached per frame.
+    vertnums = segvertexnums[line - segs];
+
     // OPTIMIZE: quickly reject orthogonal back sides.
-    angle1 = R_PointToAngle (line->v1->x, line->v1->y);
-    angle2 = R_PointToAngle (line->v2->x, line->v2->y);
+    angle1 = R_VertexAngle (vertnums[0]);
+    angle2 = R_VertexAngle (vertnums[1]);
     
     // Clip to view edges.
     // OPTIMIZE: make constant out of 2*clipangle (FIELDOFVIEW).
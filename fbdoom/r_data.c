@@ -28,7 +28,10 @@
 #include "w_wad.h"
 
 #include "doomdef.h"
+#include "m_argv.h"
 #include "m_misc.h"
+#include "sha1.h"
+#include "w_checksum.h"
 #include "r_local.h"
 #include "p_local.h"
 
@@ -151,6 +154,11 @@ short**			texturecolumnlump;
 unsigned short**	texturecolumnofs;
 byte**			texturecomposite;
 
+// The texture whose lookup is being generated or read
+//  while composited, which R_ReleaseTextureLookups must
+//  leave alone.
+static int		busytexture = -1;
+
 // for global animation
 int*		flattranslation;
 int*		texturetranslation;
@@ -217,6 +225,10 @@ R_DrawColumnInCache
 
 
 
+void R_GenerateLookup (int texnum);
+
+
+
 //
 // R_GenerateComposite
 // Using the texture definition,
@@ -236,13 +248,25 @@ void R_GenerateComposite (int texnum)
     column_t*		patchcol;
     short*		collump;
     unsigned short*	colofs;
+    int			oldbusy;
 	
     texture = textures[texnum];
 
+    oldbusy = busytexture;
+    busytexture = texnum;
+
     block = Z_Malloc (texturecompositesize[texnum],
 		      PU_STATIC, 
 		      &texturecomposite[texnum]);	
 
+    // Columns no patch covers are composited too, and
+    //  stay blank.
+    memset (block, 0, texturecompositesize[texnum]);
+
+    // Being busy, the lookup stays put from here on.
+    if (!texturecolumnlump[texnum])
+	R_GenerateLookup (texnum);
+
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
     
@@ -284,12 +308,19 @@ void R_GenerateComposite (int texnum)
     // Now that the texture has been built in column cache,
     //  it is purgable from zone memory.
     Z_ChangeTag (block, PU_CACHE);
+
+    busytexture = oldbusy;
 }
 
 
 
 //
 // R_GenerateLookup
+// Called the first time a texture is used, rather
+//  than for every texture at startup.  The lump and
+//  offset columns share one zone block, which is
+//  freed again by R_FlushTextureLookups, or by
+//  R_ReleaseTextureLookups when the zone runs low.
 //
 void R_GenerateLookup (int texnum)
 {
@@ -303,15 +334,22 @@ void R_GenerateLookup (int texnum)
     int			i;
     short*		collump;
     unsigned short*	colofs;
+    int			oldbusy;
 	
     texture = textures[texnum];
 
-    // Composited texture not created yet.
-    texturecomposite[texnum] = 0;
-    
     texturecompositesize[texnum] = 0;
-    collump = texturecolumnlump[texnum];
-    colofs = texturecolumnofs[texnum];
+
+    // The allocations and patch loads below may run the
+    //  low memory handler, which must not free this lookup.
+    oldbusy = busytexture;
+    busytexture = texnum;
+
+    collump = Z_Malloc (texture->width
+			* (sizeof(*collump) + sizeof(*colofs)),
+			PU_STATIC, &texturecolumnlump[texnum]);
+    colofs = (unsigned short *) (collump + texture->width);
+    texturecolumnofs[texnum] = colofs;
     
     // Now count the number of columns
     //  that are covered by more than one patch.
@@ -348,13 +386,16 @@ void R_GenerateLookup (int texnum)
     {
 	if (!patchcount[x])
 	{
-	    printf ("R_GenerateLookup: column without a patch (%s)\n",
-		    texture->name);
-	    return;
+	    // Vanilla gave up on the texture here and left the
+	    //  rest of the lookup unset; the column is made a
+	    //  blank one in the composite instead.
+	    if (x == 0 || patchcount[x-1])
+		printf ("R_GenerateLookup: column without a patch (%s)\n",
+			texture->name);
 	}
 	// I_Error ("R_GenerateLookup: column without a patch");
 	
-	if (patchcount[x] > 1)
+	if (patchcount[x] != 1)
 	{
 	    // Use the cached block.
 	    collump[x] = -1;	
@@ -371,6 +412,8 @@ void R_GenerateLookup (int texnum)
     }
 
     Z_Free(patchcount);
+
+    busytexture = oldbusy;
 }
 
 
@@ -386,6 +429,9 @@ R_GetColumn
 {
     int		lump;
     int		ofs;
+
+    if (!texturecolumnlump[tex])
+	R_GenerateLookup (tex);
 	
     col &= texturewidthmask[tex];
     lump = texturecolumnlump[tex][col];
@@ -401,6 +447,25 @@ R_GetColumn
 }
 
 
+//
+// R_AllocTextureLookups
+// Allocates the per-texture column lookup and composite
+//  pointers, all empty until the texture is first used.
+//
+static void R_AllocTextureLookups (void)
+{
+    texturecolumnlump = Z_Malloc (numtextures * sizeof(*texturecolumnlump), PU_STATIC, 0);
+    texturecolumnofs = Z_Malloc (numtextures * sizeof(*texturecolumnofs), PU_STATIC, 0);
+    texturecomposite = Z_Malloc (numtextures * sizeof(*texturecomposite), PU_STATIC, 0);
+    texturecompositesize = Z_Malloc (numtextures * sizeof(*texturecompositesize), PU_STATIC, 0);
+
+    memset (texturecolumnlump, 0, numtextures * sizeof(*texturecolumnlump));
+    memset (texturecolumnofs, 0, numtextures * sizeof(*texturecolumnofs));
+    memset (texturecomposite, 0, numtextures * sizeof(*texturecomposite));
+    memset (texturecompositesize, 0, numtextures * sizeof(*texturecompositesize));
+}
+
+
 static void GenerateTextureHashTable(void)
 {
     texture_t **rover;
@@ -524,12 +589,9 @@ void R_InitTextures (void)
     numtextures = numtextures1 + numtextures2;
 	
     textures = Z_Malloc (numtextures * sizeof(*textures), PU_STATIC, 0);
-    texturecolumnlump = Z_Malloc (numtextures * sizeof(*texturecolumnlump), PU_STATIC, 0);
-    texturecolumnofs = Z_Malloc (numtextures * sizeof(*texturecolumnofs), PU_STATIC, 0);
-    texturecomposite = Z_Malloc (numtextures * sizeof(*texturecomposite), PU_STATIC, 0);
-    texturecompositesize = Z_Malloc (numtextures * sizeof(*texturecompositesize), PU_STATIC, 0);
     texturewidthmask = Z_Malloc (numtextures * sizeof(*texturewidthmask), PU_STATIC, 0);
     textureheight = Z_Malloc (numtextures * sizeof(*textureheight), PU_STATIC, 0);
+    R_AllocTextureLookups ();
 
     totalwidth = 0;
     
@@ -596,9 +658,6 @@ void R_InitTextures (void)
 			 texture->name);
 	    }
 	}		
-	texturecolumnlump[i] = Z_Malloc (texture->width*sizeof(**texturecolumnlump), PU_STATIC,0);
-	texturecolumnofs[i] = Z_Malloc (texture->width*sizeof(**texturecolumnofs), PU_STATIC,0);
-
 	j = 1;
 	while (j*2 <= texture->width)
 	    j<<=1;
@@ -615,10 +674,8 @@ void R_InitTextures (void)
     if (maptex2)
         W_ReleaseLumpName(DEH_String("TEXTURE2"));
     
-    // Precalculate whatever possible.	
-
-    for (i=0 ; i<numtextures ; i++)
-	R_GenerateLookup (i);
+    // Column lookups are generated on first use,
+    //  see R_GetColumn.
     
     // Create translation table for global animation.
     texturetranslation = Z_Malloc ((numtextures+1)*sizeof(*texturetranslation), PU_STATIC, 0);
@@ -698,6 +755,328 @@ void R_InitColormaps (void)
 
 
 
+//
+// DATA INDEX
+// The texture, flat and sprite tables depend only on
+//  the WAD directory.  After the first boot they are
+//  kept in a reserved memory window, keyed by the
+//  SHA-1 of the directory, and later boots map them
+//  in place instead of parsing the lumps again.  A
+//  CRC over everything after the header catches stray
+//  writes that survived a warm reset.
+//
+
+#define DATAINDEX_MAGIC		0x49524246	// "FBRI"
+#define DATAINDEX_VERSION	3
+
+typedef struct
+{
+    int			magic;
+    int			version;
+    int			size;
+    unsigned int	crc;		// of the bytes after the header
+    sha1_digest_t	wadsha1;
+
+    int			numtextures;
+    int			firstflat;
+    int			lastflat;
+    int			firstspritelump;
+    int			lastspritelump;
+    int			numsprites;
+
+    // Byte offsets from the start of the index.
+    int			textures;	// int[numtextures], texture_t offsets
+    int			widthmask;	// int[numtextures]
+    int			heights;	// fixed_t[numtextures]
+    int			spritewidths;	// fixed_t[numspritelumps]
+    int			spriteoffsets;	// fixed_t[numspritelumps]
+    int			spritetopoffsets; // fixed_t[numspritelumps]
+    int			spritedefs;	// int[numsprites], spriteframe_t offsets
+    int			spritenumframes; // int[numsprites]
+    
+} dataindex_t;
+
+static dataindex_t*	dataindex;
+static int		dataindexsize;
+static boolean		dataindexmapped;
+static int		dataindexused;
+
+//
+// IndexAlloc
+// Reserves len bytes in the data index being written,
+//  returns the offset or -1 if the window is full.
+//
+static int IndexAlloc (int len)
+{
+    int		offset;
+
+    offset = (dataindexused + 7) & ~7;
+
+    if (offset + len > dataindexsize)
+	return -1;
+
+    dataindexused = offset + len;
+
+    return offset;
+}
+
+static int IndexWrite (void *data, int len)
+{
+    int		offset;
+
+    offset = IndexAlloc (len);
+
+    if (offset >= 0)
+	memcpy ((byte *) dataindex + offset, data, len);
+
+    return offset;
+}
+
+#define INDEXPTR(offset)	((void *) ((byte *) dataindex + (offset)))
+
+//
+// R_MapDataIndex
+// Sets up the texture, flat and sprite lump tables
+//  from a valid data index.  Returns false if there
+//  is none and they must be built from the WAD.
+//
+static boolean R_MapDataIndex (void)
+{
+    sha1_digest_t	wadsha1;
+    int*		offsets;
+    int			i;
+
+    //!
+    // @category obscure
+    //
+    // Ignore and rebuild the renderer data index.
+    //
+
+    if (M_CheckParm ("-rebuildindex"))
+	return false;
+
+    if (dataindex->magic != DATAINDEX_MAGIC
+	|| dataindex->version != DATAINDEX_VERSION
+	|| dataindex->size < (int) sizeof(dataindex_t)
+	|| dataindex->size > dataindexsize)
+    {
+	return false;
+    }
+
+    if (M_CRC32 ((byte *) (dataindex + 1),
+		 dataindex->size - sizeof(dataindex_t)) != dataindex->crc)
+    {
+	printf ("R_InitData: data index damaged, rebuilding\n");
+	return false;
+    }
+
+    W_Checksum (wadsha1);
+
+    for (i=0 ; i<sizeof(wadsha1) ; i++)
+    {
+	if (wadsha1[i] != dataindex->wadsha1[i])
+	    return false;
+    }
+
+    if (dataindex->firstflat != W_GetNumForName (DEH_String("F_START")) + 1
+	|| dataindex->firstspritelump != W_GetNumForName (DEH_String("S_START")) + 1)
+    {
+	return false;
+    }
+
+    printf ("R_InitData: using data index\n");
+
+    // Textures.
+    numtextures = dataindex->numtextures;
+
+    textures = Z_Malloc (numtextures * sizeof(*textures), PU_STATIC, 0);
+    R_AllocTextureLookups ();
+
+    offsets = INDEXPTR(dataindex->textures);
+    for (i=0 ; i<numtextures ; i++)
+	textures[i] = INDEXPTR(offsets[i]);
+
+    texturewidthmask = INDEXPTR(dataindex->widthmask);
+    textureheight = INDEXPTR(dataindex->heights);
+
+    texturetranslation = Z_Malloc ((numtextures+1)*sizeof(*texturetranslation), PU_STATIC, 0);
+    for (i=0 ; i<numtextures ; i++)
+	texturetranslation[i] = i;
+
+    GenerateTextureHashTable();
+
+    // Flats.
+    firstflat = dataindex->firstflat;
+    lastflat = dataindex->lastflat;
+    numflats = lastflat - firstflat + 1;
+
+    flattranslation = Z_Malloc ((numflats+1)*sizeof(*flattranslation), PU_STATIC, 0);
+    for (i=0 ; i<numflats ; i++)
+	flattranslation[i] = i;
+
+    // Sprite lumps.
+    firstspritelump = dataindex->firstspritelump;
+    lastspritelump = dataindex->lastspritelump;
+    numspritelumps = lastspritelump - firstspritelump + 1;
+
+    spritewidth = INDEXPTR(dataindex->spritewidths);
+    spriteoffset = INDEXPTR(dataindex->spriteoffsets);
+    spritetopoffset = INDEXPTR(dataindex->spritetopoffsets);
+
+    dataindexmapped = true;
+
+    return true;
+}
+
+//
+// R_MapIndexedSprites
+// Called by R_InitSpriteDefs.  Sets up sprites[]
+//  from the data index if one was mapped.
+//
+boolean R_MapIndexedSprites (void)
+{
+    int*	offsets;
+    int*	numframes;
+    int		i;
+
+    if (!dataindexmapped || dataindex->numsprites != numsprites)
+	return false;
+
+    sprites = Z_Malloc(numsprites *sizeof(*sprites), PU_STATIC, NULL);
+
+    offsets = INDEXPTR(dataindex->spritedefs);
+    numframes = INDEXPTR(dataindex->spritenumframes);
+
+    for (i=0 ; i<numsprites ; i++)
+    {
+	sprites[i].numframes = numframes[i];
+	sprites[i].spriteframes = INDEXPTR(offsets[i]);
+    }
+
+    return true;
+}
+
+//
+// R_SaveDataIndex
+// Called by R_InitSpriteDefs once all tables have been
+//  built from the WAD, to write them to the data index
+//  for the next boot.
+//
+void R_SaveDataIndex (void)
+{
+    dataindex_t	header;
+    int*	offsets;
+    int*	numframes;
+    texture_t*	texture;
+    int		i;
+    int		offset;
+    int		len;
+
+    if (dataindex == NULL || dataindexmapped)
+	return;
+
+    memset (&header, 0, sizeof(header));
+
+    // Invalidate whatever was there before; the header is
+    //  written last so a partial index is never used.
+    dataindex->magic = 0;
+    dataindexused = sizeof(header);
+
+    header.textures = IndexAlloc (numtextures * sizeof(int));
+    header.spritedefs = IndexAlloc (numsprites * sizeof(int));
+    header.spritenumframes = IndexAlloc (numsprites * sizeof(int));
+
+    if (header.textures < 0 || header.spritedefs < 0
+	|| header.spritenumframes < 0)
+    {
+	goto full;
+    }
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	texture = textures[i];
+	len = sizeof(texture_t) + sizeof(texpatch_t)*(texture->patchcount-1);
+
+	offset = IndexWrite (texture, len);
+	if (offset < 0)
+	    goto full;
+	offsets = INDEXPTR(header.textures);
+	offsets[i] = offset;
+    }
+
+    header.widthmask = IndexWrite (texturewidthmask,
+				   numtextures * sizeof(*texturewidthmask));
+    header.heights = IndexWrite (textureheight,
+				 numtextures * sizeof(*textureheight));
+    header.spritewidths = IndexWrite (spritewidth,
+				      numspritelumps * sizeof(*spritewidth));
+    header.spriteoffsets = IndexWrite (spriteoffset,
+				       numspritelumps * sizeof(*spriteoffset));
+    header.spritetopoffsets = IndexWrite (spritetopoffset,
+					  numspritelumps * sizeof(*spritetopoffset));
+
+    if (header.widthmask < 0 || header.heights < 0 || header.spritewidths < 0
+	|| header.spriteoffsets < 0 || header.spritetopoffsets < 0)
+    {
+	goto full;
+    }
+
+    for (i=0 ; i<numsprites ; i++)
+    {
+	offset = IndexWrite (sprites[i].spriteframes,
+			     sprites[i].numframes * sizeof(spriteframe_t));
+	if (offset < 0)
+	    goto full;
+	offsets = INDEXPTR(header.spritedefs);
+	numframes = INDEXPTR(header.spritenumframes);
+	offsets[i] = offset;
+	numframes[i] = sprites[i].numframes;
+    }
+
+    W_Checksum (header.wadsha1);
+    header.version = DATAINDEX_VERSION;
+    header.size = dataindexused;
+    header.crc = M_CRC32 ((byte *) (dataindex + 1),
+			  dataindexused - sizeof(header));
+    header.numtextures = numtextures;
+    header.firstflat = firstflat;
+    header.lastflat = lastflat;
+    header.firstspritelump = firstspritelump;
+    header.lastspritelump = lastspritelump;
+    header.numsprites = numsprites;
+
+    memcpy (dataindex, &header, sizeof(header));
+    dataindex->magic = DATAINDEX_MAGIC;
+
+    printf ("R_SaveDataIndex: %i bytes\n", dataindexused);
+    return;
+
+  full:
+    printf ("R_SaveDataIndex: window too small, index not saved\n");
+}
+
+
+//
+// R_ReleaseTextureLookups
+// Zone low memory handler.  Every column lookup can
+//  be rebuilt by R_GetColumn, so all of them go but
+//  the one being generated or composited.
+//
+static void R_ReleaseTextureLookups (void)
+{
+    int		i;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturecolumnlump[i] && i != busytexture)
+	{
+	    Z_Free (texturecolumnlump[i]);
+	    texturecolumnofs[i] = NULL;
+	}
+    }
+}
+
+
 //
 // R_InitData
 // Locates all the lumps
@@ -706,13 +1085,28 @@ void R_InitColormaps (void)
 //
 void R_InitData (void)
 {
-    R_InitTextures ();
-    printf (".");
-    R_InitFlats ();
-    printf (".");
-    R_InitSpriteLumps ();
-    printf (".");
+    //!
+    // @category obscure
+    //
+    // Do not use or write the renderer data index.
+    //
+
+    if (!M_CheckParm ("-noindex"))
+	dataindex = (dataindex_t *) I_DataIndexBase (&dataindexsize);
+
+    if (dataindex == NULL || !R_MapDataIndex ())
+    {
+	R_InitTextures ();
+	printf (".");
+	R_InitFlats ();
+	printf (".");
+	R_InitSpriteLumps ();
+	printf (".");
+    }
+
     R_InitColormaps ();
+
+    Z_AtLowMemory (R_ReleaseTextureLookups);
 }
 
 
@@ -793,6 +1187,49 @@ int	R_TextureNumForName (char* name)
 
 
 
+//
+// R_FlushTextureLookups
+// Called at level setup.  Frees the column lookups
+//  and composites of textures that the new level's
+//  sidedefs do not use; they are regenerated if
+//  an animation or switch needs them later.
+//
+void R_FlushTextureLookups (void)
+{
+    byte*	texturepresent;
+    int		i;
+
+    texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
+    memset (texturepresent,0, numtextures);
+
+    for (i=0 ; i<numsides ; i++)
+    {
+	texturepresent[sides[i].toptexture] = 1;
+	texturepresent[sides[i].midtexture] = 1;
+	texturepresent[sides[i].bottomtexture] = 1;
+    }
+
+    texturepresent[skytexture] = 1;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturepresent[i])
+	    continue;
+
+	if (texturecomposite[i])
+	    Z_Free (texturecomposite[i]);
+
+	if (texturecolumnlump[i])
+	{
+	    Z_Free (texturecolumnlump[i]);
+	    texturecolumnofs[i] = NULL;
+	}
+    }
+
+    Z_Free(texturepresent);
+}
+
+
 //
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
@@ -869,6 +1306,9 @@ void R_PrecacheLevel (void)
 	    continue;
 
 	texture = textures[i];
+
+	if (!texturecolumnlump[i])
+	    R_GenerateLookup (i);
 	
 	for (j=0 ; j<texture->patchcount ; j++)
 	{
@@ -914,3 +1354,45 @@ void R_PrecacheLevel (void)
 
 
 
+
+
+
+//
+// R_CacheLevelTextures
+// Fetches every column of every wall texture the level
+//  shows, as drawing it would, so the lookups and
+//  composites are built and relieved without drawers.
+//  Used by the headless simulation.
+//
+void R_CacheLevelTextures (void)
+{
+    char*		texturepresent;
+    int			i;
+    int			x;
+
+    texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
+    memset (texturepresent,0, numtextures);
+
+    for (i=0 ; i<numsides ; i++)
+    {
+	texturepresent[texturetranslation[sides[i].toptexture]] = 1;
+	texturepresent[texturetranslation[sides[i].midtexture]] = 1;
+	texturepresent[texturetranslation[sides[i].bottomtexture]] = 1;
+    }
+
+    texturepresent[skytexture] = 1;
+
+    // no texture
+    texturepresent[0] = 0;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (!texturepresent[i])
+	    continue;
+
+	for (x=0 ; x<textures[i]->width ; x++)
+	    R_GetColumn (i, x);
+    }
+
+    Z_Free(texturepresent);
+}
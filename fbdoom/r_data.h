@@ -35,6 +35,13 @@ R_GetColumn
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
+void R_CacheLevelTextures (void);
+void R_FlushTextureLookups (void);
+
+// Data index of the texture, flat and sprite tables,
+// see R_InitData.
+boolean R_MapIndexedSprites (void);
+void R_SaveDataIndex (void);
 
 
 // Retrieval.
@@ -127,6 +127,12 @@ typedef	struct
 
     int			linecount;
     struct line_s**	lines;	// [linecount] size
+
+    // heights before the last move, and the leveltime
+    // of that move, for interpolation in uncapped mode
+    fixed_t	oldfloorheight;
+    fixed_t	oldceilingheight;
+    int		interptic;
     
 } sector_t;
 
@@ -203,8 +209,8 @@ typedef struct line_s
     sector_t*	frontsector;
     sector_t*	backsector;
 
-    // if == validcount, already checked
-    int		validcount;
+    // Note: the validcount mark lives in the packed
+    //  linevalidcount[] array, see P_PackGeometry.
 
     // thinker_t for reversable actions
     void*	specialdata;		
@@ -255,6 +261,51 @@ typedef struct
 
 
 
+//
+// Packed copy of the two vertices of a seg or linedef.
+// The BSP walk, sight checking and movement clipping
+//  test many records but usually only need these
+//  coordinates, so they are kept in their own arrays
+//  instead of being fetched through seg_t/line_t.
+//
+typedef struct
+{
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	x2;
+    fixed_t	y2;
+    
+} vertexpair_t;
+
+
+//
+// LineDef geometry in the form used by the side
+//  and intercept tests, precalculated at level load
+//  so they need neither the vertex pointers nor
+//  the shifts.
+//
+typedef struct
+{
+    // v1, and v2 - v1.
+    fixed_t	x;
+    fixed_t	y;
+    fixed_t	dx;
+    fixed_t	dy;
+
+    // dx, dy >> FRACBITS, for P_PointOnLineSide.
+    fixed_t	dxint;
+    fixed_t	dyint;
+
+    // dx, dy >> 8, for the intercept denominator.
+    fixed_t	dxfrac;
+    fixed_t	dyfrac;
+
+    slopetype_t	slopetype;
+    
+} linegeom_t;
+
+
+
 //
 // BSP node.
 //
@@ -28,6 +28,7 @@
 
 #include "doomdef.h"
 #include "d_loop.h"
+#include "i_timer.h"
 
 #include "m_bbox.h"
 #include "m_menu.h"
@@ -35,6 +36,9 @@
 #include "r_local.h"
 #include "r_sky.h"
 
+#include "doomstat.h"
+#include "z_zone.h"
+
 
 
 
@@ -49,6 +53,27 @@ int			viewangleoffset;
 // increment every time a check is made
 int			validcount = 1;		
 
+#ifdef CYCLEPROFILE
+// cycles spent in the BSP walk, for -timedemo
+uint64_t		bspcycles;
+#endif
+
+// how far past the last tic to draw moving things and sectors;
+// FRACUNIT draws them exactly where the last tic left them
+fixed_t			fractionaltic = FRACUNIT;
+
+// heights of the sectors moved for an in-between frame
+typedef struct
+{
+    sector_t*	sector;
+    fixed_t	floorheight;
+    fixed_t	ceilingheight;
+} interpsector_t;
+
+static interpsector_t*	interpsectors;
+static int		numinterpsectors;
+
+
 
 lighttable_t*		fixedcolormap;
 extern lighttable_t**	walllights;
@@ -358,6 +383,25 @@ R_PointToAngle
 }
 
 
+//
+// R_VertexAngle
+// R_PointToAngle of a map vertex.  Neighbouring segs
+//  share their vertices, so the result is cached for
+//  the rest of the frame.
+//
+angle_t R_VertexAngle (int vertnum)
+{
+    if (vertexanglestamps[vertnum] != framecount)
+    {
+	vertexanglestamps[vertnum] = framecount;
+	vertexangles[vertnum] = R_PointToAngle (vertexes[vertnum].x,
+						vertexes[vertnum].y);
+    }
+
+    return vertexangles[vertnum];
+}
+
+
 angle_t
 R_PointToAngle2
 ( fixed_t	x1,
@@ -822,15 +866,31 @@ R_PointInSubsector
 //
 void R_SetupFrame (player_t* player)
 {		
+    mobj_t*	mo;
     int		i;
     
     viewplayer = player;
-    viewx = player->mo->x;
-    viewy = player->mo->y;
-    viewangle = player->mo->angle + viewangleoffset;
-    extralight = player->extralight;
+    mo = player->mo;
+
+    if (fractionaltic < FRACUNIT)
+    {
+	viewx = mo->oldx + FixedMul (mo->x - mo->oldx, fractionaltic);
+	viewy = mo->oldy + FixedMul (mo->y - mo->oldy, fractionaltic);
+	viewangle = mo->oldangle
+		  + FixedMul ((int) (mo->angle - mo->oldangle), fractionaltic)
+		  + viewangleoffset;
+	viewz = player->oldviewz
+	      + FixedMul (player->viewz - player->oldviewz, fractionaltic);
+    }
+    else
+    {
+	viewx = mo->x;
+	viewy = mo->y;
+	viewangle = mo->angle + viewangleoffset;
+	viewz = player->viewz;
+    }
 
-    viewz = player->viewz;
+    extralight = player->extralight;
     
     viewsin = finesine[viewangle>>ANGLETOFINESHIFT];
     viewcos = finecosine[viewangle>>ANGLETOFINESHIFT];
@@ -857,12 +917,75 @@ void R_SetupFrame (player_t* player)
 
 
 
+//
+// R_InterpolateSectors
+// Moves the floors and ceilings that moved in the last tic
+// part of the way back to where they were before it, for
+// the length of one frame.
+//
+static void R_InterpolateSectors (void)
+{
+    sector_t*	sec;
+    int		i;
+
+    numinterpsectors = 0;
+
+    if (fractionaltic >= FRACUNIT)
+	return;
+
+    if (interpsectors == NULL)
+    {
+	interpsectors = Z_Malloc (numsectors * sizeof(*interpsectors),
+				  PU_LEVEL, &interpsectors);
+    }
+
+    for (i=0, sec=sectors ; i<numsectors ; i++, sec++)
+    {
+	if (sec->interptic != leveltime-1)
+	    continue;
+
+	interpsectors[numinterpsectors].sector = sec;
+	interpsectors[numinterpsectors].floorheight = sec->floorheight;
+	interpsectors[numinterpsectors].ceilingheight = sec->ceilingheight;
+	numinterpsectors++;
+
+	sec->floorheight = sec->oldfloorheight
+	    + FixedMul (sec->floorheight - sec->oldfloorheight, fractionaltic);
+	sec->ceilingheight = sec->oldceilingheight
+	    + FixedMul (sec->ceilingheight - sec->oldceilingheight,
+			fractionaltic);
+    }
+}
+
+//
+// R_RestoreSectors
+// Puts back the heights the play simulation left.
+//
+static void R_RestoreSectors (void)
+{
+    int		i;
+
+    for (i=0 ; i<numinterpsectors ; i++)
+    {
+	interpsectors[i].sector->floorheight = interpsectors[i].floorheight;
+	interpsectors[i].sector->ceilingheight = interpsectors[i].ceilingheight;
+    }
+
+    numinterpsectors = 0;
+}
+
+
 //
 // R_RenderView
 //
 void R_RenderPlayerView (player_t* player)
 {	
+#ifdef CYCLEPROFILE
+    uint64_t	start;
+#endif
+
     R_SetupFrame (player);
+    R_InterpolateSectors ();
 
     // Clear buffers.
     R_ClearClipSegs ();
@@ -874,7 +997,13 @@ void R_RenderPlayerView (player_t* player)
     NetUpdate ();
 
     // The head node is the last node output.
+#ifdef CYCLEPROFILE
+    start = I_GetCycles ();
     R_RenderBSPNode (numnodes-1);
+    bspcycles += I_GetCycles () - start;
+#else
+    R_RenderBSPNode (numnodes-1);
+#endif
     
     // Check for new console commands.
     NetUpdate ();
@@ -886,6 +1015,8 @@ void R_RenderPlayerView (player_t* player)
     
     R_DrawMasked ();
 
+    R_RestoreSectors ();
+
     // Check for new console commands.
     NetUpdate ();				
 }
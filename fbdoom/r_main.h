@@ -46,6 +46,12 @@ extern fixed_t		projection;
 
 extern int		validcount;
 
+#ifdef CYCLEPROFILE
+extern uint64_t		bspcycles;
+#endif
+
+extern fixed_t		fractionaltic;
+
 extern int		linecount;
 extern int		loopcount;
 
@@ -116,6 +122,8 @@ R_PointToAngle
 ( fixed_t	x,
   fixed_t	y );
 
+angle_t R_VertexAngle (int vertnum);
+
 angle_t
 R_PointToAngle2
 ( fixed_t	x1,
@@ -157,4 +165,8 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// The view size and detail the next refresh will use.
+extern int		setblocks;
+extern int		setdetail;
+
 #endif
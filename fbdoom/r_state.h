@@ -90,6 +90,18 @@ extern line_t*		lines;
 extern int		numsides;
 extern side_t*		sides;
 
+// Packed hot fields, parallel to segs[] and lines[].
+extern int		(*segvertexnums)[2];
+extern int*		seglinenums;
+extern vertexpair_t*	linevertexes;
+extern linegeom_t*	linegeoms;
+extern fixed_t		(*linebboxes)[4];
+extern int*		linevalidcount;
+
+// Per-frame cache of R_PointToAngle for each vertex.
+extern angle_t*		vertexangles;
+extern int*		vertexanglestamps;
+
 
 //
 // POV data.
@@ -188,6 +188,10 @@ void R_InitSpriteDefs (char** namelist)
 	
     if (!numsprites)
 	return;
+
+    // Already built on a previous boot?
+    if (R_MapIndexedSprites ())
+	return;
 		
     sprites = Z_Malloc(numsprites *sizeof(*sprites), PU_STATIC, NULL);
 	
@@ -270,6 +274,8 @@ void R_InitSpriteDefs (char** namelist)
 	memcpy (sprites[i].spriteframes, sprtemp, maxframe*sizeof(spriteframe_t));
     }
 
+    // Keep the tables for the next boot.
+    R_SaveDataIndex ();
 }
 
 
@@ -470,10 +476,28 @@ void R_ProjectSprite (mobj_t* thing)
     
     angle_t		ang;
     fixed_t		iscale;
+
+    fixed_t		thingx;
+    fixed_t		thingy;
+    fixed_t		thingz;
+
+    // place the thing between its last two tics
+    if (fractionaltic < FRACUNIT)
+    {
+	thingx = thing->oldx + FixedMul (thing->x - thing->oldx, fractionaltic);
+	thingy = thing->oldy + FixedMul (thing->y - thing->oldy, fractionaltic);
+	thingz = thing->oldz + FixedMul (thing->z - thing->oldz, fractionaltic);
+    }
+    else
+    {
+	thingx = thing->x;
+	thingy = thing->y;
+	thingz = thing->z;
+    }
     
     // transform the origin point
-    tr_x = thing->x - viewx;
-    tr_y = thing->y - viewy;
+    tr_x = thingx - viewx;
+    tr_y = thingy - viewy;
 	
     gxt = FixedMul(tr_x,viewcos); 
     gyt = -FixedMul(tr_y,viewsin);
@@ -511,7 +535,7 @@ void R_ProjectSprite (mobj_t* thing)
     if (sprframe->rotate)
     {
 	// choose a different rotation based on player view
-	ang = R_PointToAngle (thing->x, thing->y);
+	ang = R_PointToAngle (thingx, thingy);
 	rot = (ang-thing->angle+(unsigned)(ANG45/2)*9)>>29;
 	lump = sprframe->lump[rot];
 	flip = (boolean)sprframe->flip[rot];
@@ -542,10 +566,10 @@ void R_ProjectSprite (mobj_t* thing)
     vis = R_NewVisSprite ();
     vis->mobjflags = thing->flags;
     vis->scale = xscale<<detailshift;
-    vis->gx = thing->x;
-    vis->gy = thing->y;
-    vis->gz = thing->z;
-    vis->gzt = thing->z + spritetopoffset[lump];
+    vis->gx = thingx;
+    vis->gy = thingy;
+    vis->gz = thingz;
+    vis->gzt = thingz + spritetopoffset[lump];
     vis->texturemid = vis->gzt - viewz;
     vis->x1 = x1 < 0 ? 0 : x1;
     vis->x2 = x2 >= viewwidth ? viewwidth-1 : x2;	
@@ -183,18 +183,14 @@ static void S_StopChannel(int cnum)
 }
 
 //
-// Per level startup code.
-// Kills playing sounds at start of level,
-//  determines music if any, changes music.
+// Kills every playing sound, such as when the mobjs they
+// come from are about to go away.
 //
 
-void S_Start(void)
+void S_StopSounds(void)
 {
     int cnum;
-    int mnum;
-	printf("starting sound...\n");
-    // kill all playing sounds at start of level
-    //  (trust me - a good idea)
+
     for (cnum=0 ; cnum<snd_channels ; cnum++)
     {
         if (channels[cnum].sfxinfo)
@@ -202,6 +198,21 @@ void S_Start(void)
             S_StopChannel(cnum);
         }
     }
+}
+
+//
+// Per level startup code.
+// Kills playing sounds at start of level,
+//  determines music if any, changes music.
+//
+
+void S_Start(void)
+{
+    int mnum;
+	printf("starting sound...\n");
+    // kill all playing sounds at start of level
+    //  (trust me - a good idea)
+    S_StopSounds();
 
     // start new music for the level
     mus_paused = 0;
@@ -56,6 +56,9 @@ void S_StartSound(void *origin, int sound_id);
 // Stop sound for thing at <origin>
 void S_StopSound(mobj_t *origin);
 
+// Stop every playing sound
+void S_StopSounds(void);
+
 
 // Start music using <music_id> from sounds.h
 void S_StartMusic(int music_id);
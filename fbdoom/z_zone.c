@@ -21,6 +21,7 @@
 #include "i_system.h"
 #include "doomtype.h"
 #include "stdlib.h"
+#include "string.h"
 
 //
 // ZONE MEMORY ALLOCATION
@@ -63,6 +64,17 @@ typedef struct
 
 memzone_t*	mainzone;
 
+// Bytes held by allocated blocks, and the most ever held.
+static int	zoneused;
+static int	zonepeak;
+
+// Called when an allocation fails, to release memory
+//  that can be rebuilt on demand.
+#define MAXLOWMEMFUNCS	4
+
+static zone_lowmem_func_t	lowmemfuncs[MAXLOWMEMFUNCS];
+static int			numlowmemfuncs;
+
 
 
 //
@@ -119,10 +131,66 @@ void Z_Init (void)
     block->tag = PU_FREE;
     
     block->size = mainzone->size - sizeof(memzone_t);
+
+    zoneused = zonepeak = 0;
+
+#ifdef ZONE_DEBUG
+    Z_Poison ((byte *) block + sizeof(memblock_t),
+              block->size - sizeof(memblock_t));
+#endif
     printf("b\n");
 }
 
 
+#ifdef ZONE_DEBUG
+
+//
+// Z_Poison
+//
+void Z_Poison (void *ptr, int size)
+{
+    memset (ptr, Z_POISON, size);
+}
+
+//
+// Z_CheckPoison
+// Returns false if anything wrote to the range since
+//  it was poisoned.
+//
+boolean Z_CheckPoison (void *ptr, int size)
+{
+    byte*	p;
+    int		i;
+
+    p = ptr;
+
+    for (i=0 ; i<size ; i++)
+    {
+        if (p[i] != Z_POISON)
+            return false;
+    }
+
+    return true;
+}
+
+#endif
+
+
+//
+// Z_AtLowMemory
+// Registers a function that frees memory which can be
+//  regenerated later.  These run once before Z_Malloc
+//  gives up on an allocation.
+//
+void Z_AtLowMemory (zone_lowmem_func_t func)
+{
+    if (numlowmemfuncs == MAXLOWMEMFUNCS)
+	I_Error ("Z_AtLowMemory: too many handlers");
+
+    lowmemfuncs[numlowmemfuncs++] = func;
+}
+
+
 //
 // Z_Free
 //
@@ -142,6 +210,12 @@ void Z_Free (void* ptr)
 	    *block->user = 0;
     }
 
+    zoneused -= block->size;
+
+#ifdef ZONE_DEBUG
+    Z_Poison (ptr, block->size - sizeof(memblock_t));
+#endif
+
     // mark as free
     block->tag = PU_FREE;
     block->user = NULL;
@@ -159,6 +233,11 @@ void Z_Free (void* ptr)
         if (block == mainzone->rover)
             mainzone->rover = other;
 
+#ifdef ZONE_DEBUG
+        // the old header is now free space
+        Z_Poison (block, sizeof(memblock_t));
+#endif
+
         block = other;
     }
 	
@@ -172,6 +251,10 @@ void Z_Free (void* ptr)
 
         if (other == mainzone->rover)
             mainzone->rover = block;
+
+#ifdef ZONE_DEBUG
+        Z_Poison (other, sizeof(memblock_t));
+#endif
     }
 }
 
@@ -196,6 +279,7 @@ Z_Malloc
     memblock_t* newblock;
     memblock_t*	base;
     void *result;
+    boolean	relieved;
 
     size = (size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
     
@@ -216,13 +300,30 @@ Z_Malloc
 	
     rover = base;
     start = base->prev;
+    relieved = false;
 	
     do
     {
         if (rover == start)
         {
             // scanned all the way around the list
-            I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+            if (relieved || numlowmemfuncs == 0)
+                I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+            // let the registered handlers free what they
+            // can rebuild, then scan once more
+            for (extra = 0; extra < numlowmemfuncs; extra++)
+                lowmemfuncs[extra]();
+
+            relieved = true;
+            base = mainzone->rover;
+
+            if (base->prev->tag == PU_FREE)
+                base = base->prev;
+
+            rover = base;
+            start = base->prev;
+            continue;
         }
 	
         if (rover->tag != PU_FREE)
@@ -277,8 +378,18 @@ Z_Malloc
     base->user = user;
     base->tag = tag;
 
+    zoneused += base->size;
+
+    if (zoneused > zonepeak)
+        zonepeak = zoneused;
+
     result  = (void *) ((byte *)base + sizeof(memblock_t));
 
+#ifdef ZONE_DEBUG
+    if (!Z_CheckPoison (result, size - sizeof(memblock_t)))
+        I_Error ("Z_Malloc: free block was written after it was freed");
+#endif
+
     if (base->user)
     {
         *base->user = result;
@@ -489,3 +600,22 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+//
+// Z_PeakMemory
+// Returns the most bytes ever held by allocated blocks,
+//  purgable ones included.
+//
+int Z_PeakMemory (void)
+{
+    return zonepeak;
+}
+
+//
+// Z_ResetPeakMemory
+// Starts the peak again from what is held now.
+//
+void Z_ResetPeakMemory (void)
+{
+    zonepeak = zoneused;
+}
+
@@ -26,6 +26,8 @@
 
 #include "stdio.h"
 
+#include "doomtype.h"
+
 //
 // ZONE MEMORY
 // PU - purge tags.
@@ -49,6 +51,7 @@ enum
     PU_NUM_TAGS
 };
         
+typedef void (*zone_lowmem_func_t)(void);
 
 void	Z_Init (void);
 void*	Z_Malloc (int size, int tag, void *ptr);
@@ -61,6 +64,9 @@ void    Z_ChangeTag2 (void *ptr, int tag, char *file, int line);
 void    Z_ChangeUser(void *ptr, void **user);
 int     Z_FreeMemory (void);
 unsigned int Z_ZoneSize(void);
+void    Z_AtLowMemory (zone_lowmem_func_t func);
+int     Z_PeakMemory (void);
+void    Z_ResetPeakMemory (void);
 
 //
 // This is used to get the local FILE:LINE info from CPP
@@ -69,5 +75,18 @@ unsigned int Z_ZoneSize(void);
 #define Z_ChangeTag(p,t)                                       \
     Z_ChangeTag2((p), (t), __FILE__, __LINE__)
 
+#ifdef ZONE_DEBUG
+
+// Debug builds fill freed memory with Z_POISON, so that stale
+// pointers read from it are invalid, and Z_Malloc checks that
+// nothing wrote to a block while it was free.
+
+#define Z_POISON 0xdb
+
+void    Z_Poison (void *ptr, int size);
+boolean Z_CheckPoison (void *ptr, int size);
+
+#endif
+
 
 #endif